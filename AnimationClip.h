@@ -0,0 +1,337 @@
+#ifndef ANIMATION_CLIP_H
+#define ANIMATION_CLIP_H
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "Skeleton.h"
+#include "AnimationMixer.h"
+
+// Last key segment used per channel, so sampling a playing clip resumes the search where
+// the previous frame left off instead of scanning from key 0.
+struct KeyCursor {
+    unsigned int position = 0;
+    unsigned int rotation = 0;
+    unsigned int scaling = 0;
+};
+
+// Returns the index of the key segment [i, i + 1] containing time (numKeys >= 2). Forward
+// playback advances the cursor by at most a few keys; jumping backwards past the first
+// segment (the loop wrapped) resets it, and any other seek falls back to a binary search.
+template <typename TimeAt>
+inline unsigned int findKeySegment(float time, unsigned int numKeys, unsigned int& cursor, TimeAt timeAt) {
+    unsigned int last = numKeys - 2;
+    unsigned int i = std::min(cursor, last);
+    if (time >= timeAt(i)) {
+        for (int step = 0; step < 4 && i < last && time >= timeAt(i + 1); step++) i++;
+        if (i == last || time < timeAt(i + 1)) return cursor = i;
+    } else if (time < timeAt(1)) {
+        return cursor = 0;
+    }
+    // First segment start in [1, last] that is later than time, minus one
+    unsigned int lo = 1, hi = last + 1;
+    while (lo < hi) {
+        unsigned int mid = (lo + hi) / 2;
+        if (time < timeAt(mid)) hi = mid;
+        else lo = mid + 1;
+    }
+    return cursor = lo - 1;
+}
+
+inline float keySegmentFactor(float time, float startTime, float endTime) {
+    float deltaTime = endTime - startTime;
+    if (deltaTime <= 0.0f) return 0.0f;
+    return std::clamp((time - startTime) / deltaTime, 0.0f, 1.0f);
+}
+
+// Error budget for clip compression. Keys are dropped while interpolation of the remaining
+// ones stays within these bounds.
+struct CompressionSettings {
+    bool enabled = false;
+    float rotationTolerance = 0.001f;    // radians
+    float translationTolerance = 0.01f;  // model units
+    float scaleTolerance = 0.001f;
+};
+
+// Uncompressed keys as imported, times in ticks
+struct VectorKey {
+    float time = 0.0f;
+    glm::vec3 value = glm::vec3(0.0f);
+};
+
+struct RotationKey {
+    float time = 0.0f;
+    glm::quat value = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+};
+
+struct RawChannel {
+    std::vector<VectorKey> positions;
+    std::vector<RotationKey> rotations;
+    std::vector<VectorKey> scalings;
+};
+
+// Key times in every track are quantized to 16 bits over the clip duration.
+struct CompressedVectorTrack {
+    std::vector<uint16_t> times;
+    std::vector<uint16_t> values;  // 3 per key, range-quantized over [rangeMin, rangeMin + rangeExtent]
+    glm::vec3 rangeMin = glm::vec3(0.0f);
+    glm::vec3 rangeExtent = glm::vec3(0.0f);
+};
+
+struct CompressedRotationTrack {
+    std::vector<uint16_t> times;
+    std::vector<uint16_t> values;  // 3 per key, smallest-three encoded
+};
+
+struct CompressedChannel {
+    CompressedVectorTrack translation;
+    CompressedRotationTrack rotation;
+    CompressedVectorTrack scale;
+};
+
+struct CompressedClip {
+    float duration = 0.0f;  // ticks
+    std::vector<int> channelForBone;  // index into channels, or -1 for bind pose
+    std::vector<CompressedChannel> channels;
+};
+
+struct CompressionReport {
+    std::string clipName;
+    size_t rawBytes = 0;
+    size_t compressedBytes = 0;
+    float maxRotationError = 0.0f;  // radians
+    float maxTranslationError = 0.0f;
+    float maxScaleError = 0.0f;
+};
+
+// Bake-side compression and runtime decompression of animation channels. Source keys are
+// taken through templates so any key type with time/value members can be fed in.
+class ClipCompression {
+public:
+    static constexpr float kTimeScale = 65535.0f;
+
+    template <typename VectorKey, typename QuatKey>
+    static CompressedChannel compressChannel(const VectorKey* positions, unsigned int numPositions,
+                                             const QuatKey* rotations, unsigned int numRotations,
+                                             const VectorKey* scalings, unsigned int numScalings,
+                                             float duration, const CompressionSettings& settings,
+                                             CompressionReport& report) {
+        CompressedChannel channel;
+        channel.translation = compressVectorKeys(positions, numPositions, duration, settings.translationTolerance);
+        channel.rotation = compressRotationKeys(rotations, numRotations, duration, settings.rotationTolerance);
+        channel.scale = compressVectorKeys(scalings, numScalings, duration, settings.scaleTolerance);
+
+        report.rawBytes += numPositions * sizeof(VectorKey) + numRotations * sizeof(QuatKey) + numScalings * sizeof(VectorKey);
+        report.compressedBytes += sizeInBytes(channel);
+
+        // Measure against the source keys through the same path the runtime samples with
+        float timeScale = duration > 0.0f ? kTimeScale / duration : 0.0f;
+        KeyCursor cursor;
+        for (unsigned int i = 0; i < numPositions; i++) {
+            glm::vec3 v = sampleVector(channel.translation, (float)positions[i].time * timeScale, cursor.position, glm::vec3(0.0f));
+            report.maxTranslationError = std::max(report.maxTranslationError, glm::length(v - toVec3(positions[i].value)));
+        }
+        for (unsigned int i = 0; i < numRotations; i++) {
+            glm::quat q = sampleRotation(channel.rotation, (float)rotations[i].time * timeScale, cursor.rotation, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+            report.maxRotationError = std::max(report.maxRotationError, angleBetween(q, toQuat(rotations[i].value)));
+        }
+        for (unsigned int i = 0; i < numScalings; i++) {
+            glm::vec3 v = sampleVector(channel.scale, (float)scalings[i].time * timeScale, cursor.scaling, glm::vec3(1.0f));
+            report.maxScaleError = std::max(report.maxScaleError, glm::length(v - toVec3(scalings[i].value)));
+        }
+        return channel;
+    }
+
+    // quantizedTime is the clip time in ticks multiplied by kTimeScale / duration. Tracks without
+    // keys take the bone's bind pose, as raw sampling does.
+    static void sampleChannel(const CompressedChannel& channel, float quantizedTime, KeyCursor& cursor,
+                              const BoneTransform& bind, BoneTransform& out) {
+        out.translation = sampleVector(channel.translation, quantizedTime, cursor.position, bind.translation);
+        out.rotation = sampleRotation(channel.rotation, quantizedTime, cursor.rotation, bind.rotation);
+        out.scale = sampleVector(channel.scale, quantizedTime, cursor.scaling, bind.scale);
+    }
+
+    static glm::vec3 sampleVector(const CompressedVectorTrack& track, float quantizedTime, unsigned int& cursor, const glm::vec3& fallback) {
+        unsigned int numKeys = (unsigned int)track.times.size();
+        if (numKeys == 0) return fallback;
+        if (numKeys == 1) return decodeVector(track, 0);
+        unsigned int i = findKeySegment(quantizedTime, numKeys, cursor, [&](unsigned int k) { return (float)track.times[k]; });
+        float factor = keySegmentFactor(quantizedTime, track.times[i], track.times[i + 1]);
+        return glm::mix(decodeVector(track, i), decodeVector(track, i + 1), factor);
+    }
+
+    static glm::quat sampleRotation(const CompressedRotationTrack& track, float quantizedTime, unsigned int& cursor, const glm::quat& fallback) {
+        unsigned int numKeys = (unsigned int)track.times.size();
+        if (numKeys == 0) return fallback;
+        if (numKeys == 1) return decodeRotation(&track.values[0]);
+        unsigned int i = findKeySegment(quantizedTime, numKeys, cursor, [&](unsigned int k) { return (float)track.times[k]; });
+        float factor = keySegmentFactor(quantizedTime, track.times[i], track.times[i + 1]);
+        return AnimationMixer::nlerp(decodeRotation(&track.values[i * 3]), decodeRotation(&track.values[(i + 1) * 3]), factor);
+    }
+
+    static size_t sizeInBytes(const CompressedChannel& channel) {
+        return (channel.translation.times.size() + channel.translation.values.size()) * sizeof(uint16_t) + 2 * sizeof(glm::vec3) +
+               (channel.rotation.times.size() + channel.rotation.values.size()) * sizeof(uint16_t) +
+               (channel.scale.times.size() + channel.scale.values.size()) * sizeof(uint16_t) + 2 * sizeof(glm::vec3);
+    }
+
+    // Smallest-three: drop the largest component (recoverable from unit length), quantize the
+    // other three to 15 bits each and spread its 2-bit index over the top bits of the first two.
+    static void encodeRotation(const glm::quat& rotation, uint16_t* out) {
+        glm::quat q = glm::normalize(rotation);
+        float c[4] = {q.x, q.y, q.z, q.w};
+        int largest = 0;
+        for (int i = 1; i < 4; i++) {
+            if (std::fabs(c[i]) > std::fabs(c[largest])) largest = i;
+        }
+        float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+        uint16_t packed[3];
+        int n = 0;
+        for (int i = 0; i < 4; i++) {
+            if (i == largest) continue;
+            float v = std::clamp(c[i] * sign, -kSmallestThreeRange, kSmallestThreeRange);
+            packed[n++] = (uint16_t)std::lround((v + kSmallestThreeRange) / (2.0f * kSmallestThreeRange) * 32767.0f);
+        }
+        out[0] = (uint16_t)(packed[0] | ((largest >> 1) << 15));
+        out[1] = (uint16_t)(packed[1] | ((largest & 1) << 15));
+        out[2] = packed[2];
+    }
+
+    static glm::quat decodeRotation(const uint16_t* in) {
+        int largest = ((in[0] >> 15) << 1) | (in[1] >> 15);
+        const float scale = 2.0f * kSmallestThreeRange / 32767.0f;
+        float a = (in[0] & 0x7FFF) * scale - kSmallestThreeRange;
+        float b = (in[1] & 0x7FFF) * scale - kSmallestThreeRange;
+        float d = (in[2] & 0x7FFF) * scale - kSmallestThreeRange;
+        float c[4];
+        float rest[3] = {a, b, d};
+        int n = 0;
+        for (int i = 0; i < 4; i++) {
+            if (i != largest) c[i] = rest[n++];
+        }
+        c[largest] = std::sqrt(std::max(0.0f, 1.0f - a * a - b * b - d * d));
+        return glm::quat(c[3], c[0], c[1], c[2]);
+    }
+
+private:
+    static constexpr float kSmallestThreeRange = 0.70710678f;  // 1 / sqrt(2)
+
+    template <typename Value>
+    static glm::vec3 toVec3(const Value& v) { return glm::vec3(v.x, v.y, v.z); }
+
+    template <typename Value>
+    static glm::quat toQuat(const Value& q) { return glm::normalize(glm::quat(q.w, q.x, q.y, q.z)); }
+
+    // atan2 form stays accurate for tiny angles, where acos(dot) loses most of its precision
+    static float angleBetween(const glm::quat& a, const glm::quat& b) {
+        glm::quat bAligned = glm::dot(a, b) < 0.0f ? -b : b;
+        return 2.0f * std::atan2(glm::length(a - bAligned), glm::length(a + bAligned));
+    }
+
+    static uint16_t quantizeTime(double time, float duration) {
+        if (duration <= 0.0f) return 0;
+        return (uint16_t)std::lround(std::clamp((float)time / duration, 0.0f, 1.0f) * kTimeScale);
+    }
+
+    static glm::vec3 decodeVector(const CompressedVectorTrack& track, unsigned int key) {
+        const uint16_t* v = &track.values[key * 3];
+        return track.rangeMin + track.rangeExtent * (glm::vec3(v[0], v[1], v[2]) / 65535.0f);
+    }
+
+    // Share of the tolerance spent on key reduction; the rest absorbs value/time quantization
+    static constexpr float kReductionBudget = 0.75f;
+
+    // Greedy key reduction: keeps a key only if linear interpolation between the last kept key
+    // and its successor would miss one of the keys in between. fits(a, b, k) tests key k
+    // against the interpolation between keys a and b. A track whose keys all stay within
+    // tolerance of the first one collapses to a single key.
+    template <typename Fits>
+    static std::vector<unsigned int> reduceKeys(unsigned int numKeys, Fits fits, bool constant) {
+        std::vector<unsigned int> kept;
+        if (numKeys == 0) return kept;
+        kept.push_back(0);
+        if (constant || numKeys == 1) return kept;
+        unsigned int anchor = 0;
+        for (unsigned int i = 1; i + 1 < numKeys; i++) {
+            bool skippable = true;
+            for (unsigned int k = anchor + 1; k <= i && skippable; k++) skippable = fits(anchor, i + 1, k);
+            if (!skippable) {
+                kept.push_back(i);
+                anchor = i;
+            }
+        }
+        kept.push_back(numKeys - 1);
+        return kept;
+    }
+
+    template <typename Key>
+    static CompressedVectorTrack compressVectorKeys(const Key* keys, unsigned int numKeys, float duration, float tolerance) {
+        CompressedVectorTrack track;
+        if (numKeys == 0) return track;
+        tolerance *= kReductionBudget;
+
+        bool constant = true;
+        for (unsigned int k = 1; k < numKeys && constant; k++) {
+            constant = glm::length(toVec3(keys[k].value) - toVec3(keys[0].value)) <= tolerance;
+        }
+        auto fits = [&](unsigned int a, unsigned int b, unsigned int k) {
+            float factor = keySegmentFactor((float)keys[k].time, (float)keys[a].time, (float)keys[b].time);
+            glm::vec3 interpolated = glm::mix(toVec3(keys[a].value), toVec3(keys[b].value), factor);
+            return glm::length(interpolated - toVec3(keys[k].value)) <= tolerance;
+        };
+        std::vector<unsigned int> kept = reduceKeys(numKeys, fits, constant);
+
+        glm::vec3 lo = toVec3(keys[kept[0]].value), hi = lo;
+        for (unsigned int k : kept) {
+            lo = glm::min(lo, toVec3(keys[k].value));
+            hi = glm::max(hi, toVec3(keys[k].value));
+        }
+        track.rangeMin = lo;
+        track.rangeExtent = hi - lo;
+
+        track.times.reserve(kept.size());
+        track.values.reserve(kept.size() * 3);
+        for (unsigned int k : kept) {
+            track.times.push_back(quantizeTime(keys[k].time, duration));
+            glm::vec3 v = toVec3(keys[k].value);
+            for (int c = 0; c < 3; c++) {
+                float normalized = track.rangeExtent[c] > 0.0f ? (v[c] - lo[c]) / track.rangeExtent[c] : 0.0f;
+                track.values.push_back((uint16_t)std::lround(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+            }
+        }
+        return track;
+    }
+
+    template <typename Key>
+    static CompressedRotationTrack compressRotationKeys(const Key* keys, unsigned int numKeys, float duration, float tolerance) {
+        CompressedRotationTrack track;
+        if (numKeys == 0) return track;
+        tolerance *= kReductionBudget;
+
+        bool constant = true;
+        for (unsigned int k = 1; k < numKeys && constant; k++) {
+            constant = angleBetween(toQuat(keys[k].value), toQuat(keys[0].value)) <= tolerance;
+        }
+        auto fits = [&](unsigned int a, unsigned int b, unsigned int k) {
+            float factor = keySegmentFactor((float)keys[k].time, (float)keys[a].time, (float)keys[b].time);
+            glm::quat interpolated = AnimationMixer::nlerp(toQuat(keys[a].value), toQuat(keys[b].value), factor);
+            return angleBetween(interpolated, toQuat(keys[k].value)) <= tolerance;
+        };
+        std::vector<unsigned int> kept = reduceKeys(numKeys, fits, constant);
+
+        track.times.reserve(kept.size());
+        track.values.resize(kept.size() * 3);
+        for (size_t i = 0; i < kept.size(); i++) {
+            track.times.push_back(quantizeTime(keys[kept[i]].time, duration));
+            encodeRotation(toQuat(keys[kept[i]].value), &track.values[i * 3]);
+        }
+        return track;
+    }
+};
+
+#endif
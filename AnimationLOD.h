@@ -0,0 +1,234 @@
+#ifndef ANIMATION_LOD_H
+#define ANIMATION_LOD_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <limits>
+#include <chrono>
+#include <algorithm>
+#include "FBXStateMachine.h"
+#include "JobSystem.h"
+
+// How an instance is animated at a given distance. updateInterval 1 updates every frame, N every
+// Nth frame (with the elapsed time applied in one step), 0 freezes the pose. A bone whose name
+// contains one of skippedSubtrees is held in its bind pose together with all its descendants.
+struct AnimationLODTier {
+    float maxDistance = std::numeric_limits<float>::max();
+    int updateInterval = 1;
+    std::vector<std::string> skippedSubtrees;
+};
+
+// Per-instance input for one frame, usually distance to the camera and a frustum test
+struct AnimationLODInput {
+    float distance = 0.0f;
+    bool visible = true;
+};
+
+// Picks an LOD tier per instance and decides which instances update this frame. Instances that
+// share an update interval are spread over its frames by their slot index, and when a CPU budget
+// is set the due instances are time-sliced: the most overdue ones run first and the rest wait
+// for a later frame, still accumulating their elapsed time.
+class AnimationScheduler {
+public:
+    struct Stats {
+        size_t updated = 0;
+        size_t deferred = 0;      // due, but pushed to a later frame by the budget
+        size_t skipped = 0;       // not due this frame, or frozen
+        size_t sampledBones = 0;
+        float elapsedMs = 0.0f;
+    };
+
+    AnimationScheduler() { tiers.push_back(AnimationLODTier()); }
+
+    // tiers are sorted by maxDistance; an instance uses the first one covering its distance, or
+    // the last one beyond that. Invisible instances use offscreenTier (-1 to ignore visibility).
+    void setTiers(std::vector<AnimationLODTier> newTiers, int newOffscreenTier = -1) {
+        tiers = std::move(newTiers);
+        if (tiers.empty()) tiers.push_back(AnimationLODTier());
+        offscreenTier = newOffscreenTier < (int)tiers.size() ? newOffscreenTier : -1;
+        // Bone lists are rebuilt for the new tiers, so no instance may keep pointing at the old ones
+        for (Slot& slot : slots) {
+            if (slot.instance) slot.instance->setSampledBones(nullptr);
+            slot.tier = -1;
+        }
+        boneSets.clear();
+    }
+
+    // Wall-clock time the animation updates may take per frame, 0 for no limit
+    void setCpuBudget(float milliseconds) { budgetMs = milliseconds; }
+
+    // Runs this frame's updates. instances[i] keeps its LOD state in slot i, so pass instances in
+    // a stable order; inputs may be null to treat every instance as near and visible.
+    void update(FBXStateMachine* const* instances, const AnimationLODInput* inputs, size_t count, float dt, JobSystem* jobs) {
+        using Clock = std::chrono::steady_clock;
+        stats = Stats();
+        slots.resize(count);
+        due.clear();
+        // Bone sets of assets nobody holds any more; a later asset may reuse the address. Live
+        // ones stay even if no slot uses them, as an instance that left may still point into them.
+        for (auto it = boneSets.begin(); it != boneSets.end();) {
+            if (it->second.asset.expired()) it = boneSets.erase(it);
+            else ++it;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            Slot& slot = slots[i];
+            FBXStateMachine* instance = instances[i];
+            if (slot.instance != instance) {
+                slot = Slot();
+                slot.instance = instance;
+            }
+            int tier = selectTier(inputs ? inputs[i] : AnimationLODInput());
+            // setAsset clears the bone subset, so a swapped asset needs it assigned again
+            if (tier != slot.tier || slot.asset != instance->getAsset().get()) {
+                slot.tier = tier;
+                slot.asset = instance->getAsset().get();
+                instance->setSampledBones(sampledBonesFor(*instance, tier));
+            }
+            slot.pendingTime += dt;
+            slot.framesSinceUpdate++;
+
+            int interval = tiers[tier].updateInterval;
+            // A new instance always gets its first pose, even in a frozen tier
+            bool isDue = !slot.hasUpdated || (interval > 0 && slot.framesSinceUpdate >= interval);
+            if (!isDue) {
+                stats.skipped++;
+                continue;
+            }
+            due.push_back(i);
+        }
+
+        // Most overdue first, relative to the instance's own interval
+        std::stable_sort(due.begin(), due.end(), [this](size_t a, size_t b) {
+            return overdue(slots[a]) > overdue(slots[b]);
+        });
+
+        selected.clear();
+        float estimatedMs = 0.0f;
+        size_t work = 0;
+        for (size_t i : due) {
+            size_t instanceWork = workFor(*slots[i].instance);
+            float costMs = costPerWorkMs * instanceWork;
+            if (budgetMs > 0.0f && !selected.empty() && estimatedMs + costMs > budgetMs) {
+                stats.deferred++;
+                continue;
+            }
+            estimatedMs += costMs;
+            work += instanceWork;
+            selected.push_back(i);
+        }
+
+        auto start = Clock::now();
+        auto updateRange = [this](size_t begin, size_t end) {
+            for (size_t n = begin; n < end; n++) {
+                Slot& slot = slots[selected[n]];
+                slot.instance->update(slot.pendingTime);
+            }
+        };
+        if (jobs) jobs->parallelFor(selected.size(), 16, updateRange);
+        else updateRange(0, selected.size());
+        stats.elapsedMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+        for (size_t i : selected) {
+            Slot& slot = slots[i];
+            slot.pendingTime = 0.0f;
+            // Stagger by slot index after the first update so instances sharing an interval
+            // don't all land on the same frame
+            int interval = std::max(tiers[slot.tier].updateInterval, 1);
+            slot.framesSinceUpdate = slot.hasUpdated ? 0 : -(int)(i % interval);
+            slot.hasUpdated = true;
+        }
+        stats.updated = selected.size();
+        stats.sampledBones = work;
+
+        if (work > 0) {
+            float measured = stats.elapsedMs / work;
+            costPerWorkMs = costPerWorkMs > 0.0f ? costPerWorkMs * 0.8f + measured * 0.2f : measured;
+        }
+    }
+
+    int getTier(size_t slot) const { return slot < slots.size() ? slots[slot].tier : -1; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Slot {
+        FBXStateMachine* instance = nullptr;
+        const CharacterAsset* asset = nullptr;
+        int tier = -1;
+        int framesSinceUpdate = 0;
+        float pendingTime = 0.0f;
+        bool hasUpdated = false;
+    };
+
+    // Bone subsets per tier for one asset; an empty list with full = true means every bone. The
+    // asset is only watched, so AssetDatabase can still evict it.
+    struct BoneSets {
+        std::weak_ptr<const CharacterAsset> asset;
+        std::vector<std::vector<int>> sampledBones;
+        std::vector<bool> full;
+    };
+
+    int selectTier(const AnimationLODInput& input) const {
+        if (!input.visible && offscreenTier >= 0) return offscreenTier;
+        for (size_t t = 0; t < tiers.size(); t++) {
+            if (input.distance <= tiers[t].maxDistance) return (int)t;
+        }
+        return (int)tiers.size() - 1;
+    }
+
+    float overdue(const Slot& slot) const {
+        if (!slot.hasUpdated) return std::numeric_limits<float>::max();
+        return (float)slot.framesSinceUpdate / std::max(tiers[slot.tier].updateInterval, 1);
+    }
+
+    // Cost model: sampling scales with the sampled bones, hierarchy evaluation with all of them
+    size_t workFor(const FBXStateMachine& instance) const {
+        const std::vector<int>* sampled = instance.getSampledBones();
+        size_t boneCount = instance.getSkeleton().size();
+        return (sampled ? sampled->size() : boneCount) + boneCount;
+    }
+
+    const std::vector<int>* sampledBonesFor(const FBXStateMachine& instance, int tier) {
+        const auto& asset = instance.getAsset();
+        if (!asset || tiers[tier].skippedSubtrees.empty()) return nullptr;
+
+        auto it = boneSets.find(asset.get());
+        if (it == boneSets.end()) {
+            BoneSets sets;
+            sets.asset = asset;
+            const Skeleton& skeleton = asset->getSkeleton();
+            for (const AnimationLODTier& lodTier : tiers) {
+                // Depth-first order: a bone's parent is always decided before the bone itself
+                std::vector<char> skipped(skeleton.size(), 0);
+                std::vector<int> bones;
+                for (size_t i = 0; i < skeleton.size(); i++) {
+                    int parent = skeleton.parentIndices[i];
+                    skipped[i] = parent >= 0 && skipped[parent];
+                    for (const std::string& name : lodTier.skippedSubtrees) {
+                        if (!skipped[i] && skeleton.names[i].find(name) != std::string::npos) skipped[i] = 1;
+                    }
+                    if (!skipped[i]) bones.push_back((int)i);
+                }
+                sets.full.push_back(bones.size() == skeleton.size());
+                sets.sampledBones.push_back(std::move(bones));
+            }
+            it = boneSets.emplace(asset.get(), std::move(sets)).first;
+        }
+        return it->second.full[tier] ? nullptr : &it->second.sampledBones[tier];
+    }
+
+    std::vector<AnimationLODTier> tiers;
+    int offscreenTier = -1;
+    float budgetMs = 0.0f;
+    float costPerWorkMs = 0.0f;  // running average of measured update cost
+
+    std::vector<Slot> slots;
+    std::map<const CharacterAsset*, BoneSets> boneSets;
+    std::vector<size_t> due;
+    std::vector<size_t> selected;
+    Stats stats;
+};
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef ANIMATION_LAYERS_H
+#define ANIMATION_LAYERS_H
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Skeleton.h"
+#include "AnimationClip.h"
+#include "AnimationMixer.h"
+#include "CharacterAsset.h"
+
+// Sparse per-bone weights: the bones a layer touches, sorted by index, with a weight for each.
+// Bones not listed are skipped entirely by the layer.
+struct BoneMask {
+    std::vector<int> bones;
+    std::vector<float> weights;
+
+    // Sets rootName and all its descendants to weight (0 removes them). Later calls override
+    // earlier ones, so a mask can be tapered, e.g. spine at 0.5 then the arms at 1.
+    bool setSubtree(const Skeleton& skeleton, const std::string& rootName, float weight) {
+        int root = -1;
+        for (size_t i = 0; i < skeleton.size(); i++) {
+            if (skeleton.names[i] == rootName) {
+                root = (int)i;
+                break;
+            }
+        }
+        if (root < 0) return false;
+
+        std::vector<float> dense(skeleton.size(), 0.0f);
+        for (size_t n = 0; n < bones.size(); n++) dense[bones[n]] = weights[n];
+        // Depth-first order: the subtree is the run of bones after root whose parent is inside it
+        std::vector<char> inside(skeleton.size(), 0);
+        inside[root] = 1;
+        dense[root] = weight;
+        for (size_t i = root + 1; i < skeleton.size(); i++) {
+            int parent = skeleton.parentIndices[i];
+            if (parent < 0 || !inside[parent]) break;
+            inside[i] = 1;
+            dense[i] = weight;
+        }
+
+        bones.clear();
+        weights.clear();
+        for (size_t i = 0; i < dense.size(); i++) {
+            if (dense[i] <= 0.0f) continue;
+            bones.push_back((int)i);
+            weights.push_back(dense[i]);
+        }
+        return true;
+    }
+};
+
+enum class LayerBlendMode {
+    Override,  // lerp towards the layer's pose
+    Additive   // add the layer's difference from its reference pose
+};
+
+// Clip layers applied on top of an instance's base pose (its state clip and crossfade), bottom
+// to top. Each layer only samples and blends the bones in its mask, so masked-out bones cost
+// nothing. All buffers are sized when layers are added; apply() never allocates.
+class AnimationLayerStack {
+public:
+    struct Layer {
+        int clipIndex = -1;
+        LayerBlendMode mode = LayerBlendMode::Override;
+        float weight = 1.0f;
+        float speed = 1.0f;
+        BoneMask mask;  // the layer's own copy, so later edits to the caller's mask don't reach it
+
+        float time = 0.0f;
+        std::vector<KeyCursor> cursors;
+        std::vector<BoneTransform> referencePose;  // additive only, one entry per mask bone
+    };
+
+    // Drops all layers (masks and clip indices belong to the old asset) and sizes the scratch pose
+    void reset(const CharacterAsset* newAsset) {
+        asset = newAsset;
+        layers.clear();
+        scratch.assign(asset ? asset->getSkeleton().size() : 0, BoneTransform());
+    }
+
+    // Returns the layer index. The mask is copied; null covers every bone at full weight.
+    // Additive layers take their reference pose from the first frame of their own clip until
+    // setReferencePose picks another one.
+    int addLayer(int clipIndex, LayerBlendMode mode, const BoneMask* mask, float weight = 1.0f) {
+        Layer layer;
+        layer.clipIndex = clipIndex;
+        layer.mode = mode;
+        if (mask) {
+            layer.mask = *mask;
+        } else {
+            for (size_t i = 0; i < scratch.size(); i++) layer.mask.bones.push_back((int)i);
+            layer.mask.weights.assign(scratch.size(), 1.0f);
+        }
+        layer.weight = std::clamp(weight, 0.0f, 1.0f);
+        layer.cursors.assign(scratch.size(), KeyCursor());
+        layers.push_back(std::move(layer));
+        int index = (int)layers.size() - 1;
+        if (mode == LayerBlendMode::Additive) setReferencePose(index, clipIndex, 0.0f);
+        return index;
+    }
+
+    void setReferencePose(int layer, int clipIndex, float timeSeconds) {
+        Layer& l = layers[layer];
+        const CharacterAsset::CompiledClip* reference = clip(clipIndex);
+        std::vector<KeyCursor> cursors(scratch.size());
+        float ticks = reference ? timeSeconds * reference->ticksPerSecond : 0.0f;
+        sampleLayerBones(l, ticks, reference, cursors.data());
+        size_t count = l.mask.bones.size();
+        l.referencePose.resize(count);
+        for (size_t n = 0; n < count; n++) l.referencePose[n] = scratch[l.mask.bones[n]];
+    }
+
+    void setWeight(int layer, float weight) { layers[layer].weight = std::clamp(weight, 0.0f, 1.0f); }
+    void setSpeed(int layer, float speed) { layers[layer].speed = speed; }
+
+    // Switches the layer to another clip from its start; the reference pose is kept
+    void setClip(int layer, int clipIndex) {
+        Layer& l = layers[layer];
+        l.clipIndex = clipIndex;
+        l.time = 0.0f;
+        std::fill(l.cursors.begin(), l.cursors.end(), KeyCursor());
+    }
+
+    size_t size() const { return layers.size(); }
+    bool hasActiveLayers() const {
+        for (const Layer& l : layers) {
+            if (l.weight > 0.0f && clip(l.clipIndex)) return true;
+        }
+        return false;
+    }
+    const Layer& getLayer(int layer) const { return layers[layer]; }
+
+    // Advances every layer by dt and blends them into pose, one entry per skeleton bone
+    void apply(float dt, BoneTransform* pose) {
+        for (Layer& l : layers) {
+            const CharacterAsset::CompiledClip* c = clip(l.clipIndex);
+            if (!c) continue;
+            float duration = c->duration / c->ticksPerSecond;
+            l.time += dt * l.speed;
+            if (duration > 0.0f) {
+                l.time = std::fmod(l.time, duration);
+                if (l.time < 0.0f) l.time += duration;
+            }
+            // A layer faded out keeps its clock running but costs nothing else
+            if (l.weight <= 0.0f) continue;
+
+            sampleLayerBones(l, l.time * c->ticksPerSecond, c, l.cursors.data());
+            size_t count = l.mask.bones.size();
+            for (size_t n = 0; n < count; n++) {
+                int i = l.mask.bones[n];
+                float w = l.weight * l.mask.weights[n];
+                if (l.mode == LayerBlendMode::Additive) {
+                    AnimationMixer::addDelta(pose[i], scratch[i], l.referencePose[n], w, pose[i]);
+                } else {
+                    AnimationMixer::blend(&pose[i], &scratch[i], w, &pose[i], 1);
+                }
+            }
+        }
+    }
+
+private:
+    const CharacterAsset::CompiledClip* clip(int clipIndex) const {
+        if (!asset || clipIndex < 0 || clipIndex >= (int)asset->getClips().size()) return nullptr;
+        return &asset->getClips()[clipIndex];
+    }
+
+    void sampleLayerBones(const Layer& layer, float ticks, const CharacterAsset::CompiledClip* c, KeyCursor* cursors) {
+        if (!asset) return;
+        asset->sampleClip(ticks, c, cursors, scratch.data(), layer.mask.bones.data(), layer.mask.bones.size());
+    }
+
+    const CharacterAsset* asset = nullptr;
+    std::vector<Layer> layers;
+    std::vector<BoneTransform> scratch;
+};
+
+#endif
@@ -1,21 +1,47 @@
 #ifndef ANIMATION_MIXER_H
 #define ANIMATION_MIXER_H
 
-#include <vector>
+#include <cstddef>
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "Skeleton.h"
 
 class AnimationMixer {
 public:
-    static std::vector<glm::mat4> blend(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b, float alpha) {
-        if (alpha <= 0.0f) return a;
-        if (alpha >= 1.0f) return b;
-        
-        std::vector<glm::mat4> result(a.size());
-        for (size_t i = 0; i < a.size(); i++) {
-            // Simplified matrix LERP (Should decompose to translation/rotation/scale for true results)
-            result[i] = a[i] * (1.0f - alpha) + b[i] * alpha;
+    // Blends two local poses into out (which may alias a or b). Translation and scale are
+    // lerped, rotation uses a normalized lerp along the shortest arc.
+    static void blend(const BoneTransform* a, const BoneTransform* b, float alpha, BoneTransform* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            out[i].translation = glm::mix(a[i].translation, b[i].translation, alpha);
+            out[i].rotation = nlerp(a[i].rotation, b[i].rotation, alpha);
+            out[i].scale = glm::mix(a[i].scale, b[i].scale, alpha);
         }
-        return result;
+    }
+
+    // Same as above, restricted to the listed bones
+    static void blend(const BoneTransform* a, const BoneTransform* b, float alpha, BoneTransform* out,
+                      const int* boneIndices, size_t count) {
+        for (size_t n = 0; n < count; n++) {
+            int i = boneIndices[n];
+            out[i].translation = glm::mix(a[i].translation, b[i].translation, alpha);
+            out[i].rotation = nlerp(a[i].rotation, b[i].rotation, alpha);
+            out[i].scale = glm::mix(a[i].scale, b[i].scale, alpha);
+        }
+    }
+
+    // Adds weight * (additive - reference) onto base for one bone. The rotation difference is
+    // taken in the bone's local space, scale as a ratio.
+    static void addDelta(const BoneTransform& base, const BoneTransform& additive, const BoneTransform& reference,
+                         float weight, BoneTransform& out) {
+        glm::quat delta = glm::inverse(reference.rotation) * additive.rotation;
+        out.translation = base.translation + (additive.translation - reference.translation) * weight;
+        out.rotation = glm::normalize(base.rotation * nlerp(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), delta, weight));
+        out.scale = base.scale * glm::mix(glm::vec3(1.0f), additive.scale / reference.scale, weight);
+    }
+
+    static glm::quat nlerp(const glm::quat& a, const glm::quat& b, float alpha) {
+        float bSign = glm::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+        return glm::normalize(a * (1.0f - alpha) + b * (alpha * bSign));
     }
 };
 
@@ -6,6 +6,8 @@
 #include <map>
 #include <fstream>
 #include <nlohmann/json.hpp>
+#include "AnimationClip.h"
+#include "AnimationLOD.h"
 
 using json = nlohmann::json;
 
@@ -13,6 +15,9 @@ struct BakedAsset {
     std::string skeleton;
     std::map<std::string, int> states;
     std::vector<std::string> textures;
+    // GPU encodings baked for every texture ("bc", "etc2", "rgba8"); the runtime uploads the
+    // first one the device supports, so keep "rgba8" last as the fallback
+    std::vector<std::string> textureFormats = {"bc", "etc2", "rgba8"};
     struct PhysicsConfig {
         std::string bone;
         float radius;
@@ -20,6 +25,15 @@ struct BakedAsset {
         float damage;
     };
     std::vector<PhysicsConfig> colliders;
+    CompressionSettings compression;
+    bool optimizeMeshes = true;  // vertex cache / fetch reordering at bake time
+    struct PaletteBakeConfig {
+        int clip;
+        float framesPerSecond;
+    };
+    std::vector<PaletteBakeConfig> paletteBakes;
+    std::vector<AnimationLODTier> lodTiers;
+    int lodOffscreenTier = -1;
 };
 
 class AssetBaking {
@@ -29,11 +43,31 @@ public:
         j["skeleton"] = asset.skeleton;
         j["states"] = asset.states;
         j["textures"] = asset.textures;
+        j["textureFormats"] = asset.textureFormats;
         for (const auto& c : asset.colliders) {
             j["physics"]["colliders"].push_back({
                 {"bone", c.bone}, {"radius", c.radius}, {"height", c.height}, {"damage", c.damage}
             });
         }
+        j["optimizeMeshes"] = asset.optimizeMeshes;
+        j["compression"] = {
+            {"enabled", asset.compression.enabled},
+            {"rotationTolerance", asset.compression.rotationTolerance},
+            {"translationTolerance", asset.compression.translationTolerance},
+            {"scaleTolerance", asset.compression.scaleTolerance}
+        };
+        for (const auto& b : asset.paletteBakes) {
+            j["paletteBakes"].push_back({{"clip", b.clip}, {"framesPerSecond", b.framesPerSecond}});
+        }
+        if (!asset.lodTiers.empty()) {
+            for (const auto& tier : asset.lodTiers) {
+                j["lod"]["tiers"].push_back({
+                    {"maxDistance", tier.maxDistance}, {"updateInterval", tier.updateInterval},
+                    {"skippedSubtrees", tier.skippedSubtrees}
+                });
+            }
+            j["lod"]["offscreenTier"] = asset.lodOffscreenTier;
+        }
         std::ofstream file(path);
         file << j.dump(4);
     }
@@ -46,11 +80,38 @@ public:
         asset.skeleton = j["skeleton"];
         asset.states = j["states"].get<std::map<std::string, int>>();
         asset.textures = j["textures"].get<std::vector<std::string>>();
+        asset.textureFormats = j.value("textureFormats", asset.textureFormats);
         for (auto& item : j["physics"]["colliders"]) {
             asset.colliders.push_back({
                 item["bone"], item["radius"], item["height"], item["damage"]
             });
         }
+        asset.optimizeMeshes = j.value("optimizeMeshes", true);
+        if (j.contains("compression")) {
+            const auto& c = j["compression"];
+            asset.compression.enabled = c.value("enabled", false);
+            asset.compression.rotationTolerance = c.value("rotationTolerance", asset.compression.rotationTolerance);
+            asset.compression.translationTolerance = c.value("translationTolerance", asset.compression.translationTolerance);
+            asset.compression.scaleTolerance = c.value("scaleTolerance", asset.compression.scaleTolerance);
+        }
+        if (j.contains("paletteBakes")) {
+            for (const auto& item : j["paletteBakes"]) {
+                asset.paletteBakes.push_back({item.value("clip", 0), item.value("framesPerSecond", 30.0f)});
+            }
+        }
+        if (j.contains("lod")) {
+            const auto& lod = j["lod"];
+            if (lod.contains("tiers")) {
+                for (const auto& item : lod["tiers"]) {
+                    AnimationLODTier tier;
+                    tier.maxDistance = item.value("maxDistance", tier.maxDistance);
+                    tier.updateInterval = item.value("updateInterval", tier.updateInterval);
+                    tier.skippedSubtrees = item.value("skippedSubtrees", std::vector<std::string>());
+                    asset.lodTiers.push_back(tier);
+                }
+            }
+            asset.lodOffscreenTier = lod.value("offscreenTier", -1);
+        }
         return asset;
     }
 };
@@ -0,0 +1,205 @@
+#include "AssetChunks.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include "CharacterAssetFile.h"
+#include "TextureCompression.h"
+
+static const char* formatTag(CharacterAsset::TextureFormat format) {
+    switch (format) {
+        case CharacterAsset::TextureFormat::RGBA8: return "rgba8";
+        case CharacterAsset::TextureFormat::BC1: return "bc1";
+        case CharacterAsset::TextureFormat::BC3: return "bc3";
+        case CharacterAsset::TextureFormat::ETC2_RGB8: return "etc2rgb";
+        case CharacterAsset::TextureFormat::ETC2_RGBA8: return "etc2rgba";
+    }
+    return "unknown";
+}
+
+static bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    if (!out) std::cerr << "Cannot write " << path << std::endl;
+    return (bool)out;
+}
+
+static size_t fileSize(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return in ? (size_t)in.tellg() : 0;
+}
+
+const AssetChunks::Character* AssetChunks::Manifest::find(const std::string& name) const {
+    for (const Character& character : characters) {
+        if (character.name == name) return &character;
+    }
+    return nullptr;
+}
+
+bool AssetChunks::write(const std::string& directory, const std::string& name, const CharacterAsset& asset,
+                        const BakedAsset& config) {
+    std::string prefix = directory.empty() || directory.back() == '/' ? directory : directory + "/";
+    Character character;
+    character.name = name;
+
+    CharacterAsset core;
+    core.skeleton = asset.skeleton;
+    core.clips = asset.clips;
+    character.core.url = name + ".core.character";
+    if (!CharacterAssetFile::save(prefix + character.core.url, core, config)) return false;
+    character.core.bytes = fileSize(prefix + character.core.url);
+
+    CharacterAsset meshes;
+    meshes.meshes = asset.meshes;
+    character.meshes.url = name + ".meshes.character";
+    if (!CharacterAssetFile::save(prefix + character.meshes.url, meshes, BakedAsset())) return false;
+    character.meshes.bytes = fileSize(prefix + character.meshes.url);
+
+    for (size_t t = 0; t < asset.bakedTextures.size(); t++) {
+        const CharacterAsset::BakedTexture& baked = asset.bakedTextures[t];
+        Texture texture;
+        texture.name = baked.name;
+        texture.width = baked.width;
+        texture.height = baked.height;
+        for (const CharacterAsset::TexturePayload& source : baked.payloads) {
+            if (source.levels.empty()) continue;
+            texture.levelCount = (uint32_t)source.levels.size();
+            Payload payload;
+            payload.format = source.format;
+
+            // Walk from the 1x1 level up: everything within kTailSize shares the first chunk
+            uint32_t end = (uint32_t)source.levels.size();
+            while (end > 0) {
+                uint32_t first = end - 1;
+                while (first > 0 && std::max(source.levels[first - 1].width, source.levels[first - 1].height) <= kTailSize &&
+                       end == source.levels.size()) {
+                    first--;
+                }
+                LevelChunk levelChunk;
+                levelChunk.firstLevel = first;
+                levelChunk.levelCount = end - first;
+                levelChunk.chunk.url = name + ".t" + std::to_string(t) + "." + formatTag(source.format) + ".l" + std::to_string(first) + ".bin";
+                std::vector<uint8_t> bytes;
+                for (uint32_t level = first; level < end; level++) {
+                    bytes.insert(bytes.end(), source.levels[level].data.begin(), source.levels[level].data.end());
+                }
+                levelChunk.chunk.bytes = bytes.size();
+                if (!writeFile(prefix + levelChunk.chunk.url, bytes)) return false;
+                payload.chunks.push_back(levelChunk);
+                end = first;
+            }
+            texture.payloads.push_back(std::move(payload));
+        }
+        if (!texture.payloads.empty()) character.textures.push_back(std::move(texture));
+    }
+
+    // Other characters already in the manifest stay listed
+    std::string manifestPath = prefix + "manifest.json";
+    json manifest = {{"version", kVersion}, {"characters", json::array()}};
+    std::ifstream existing(manifestPath);
+    if (existing) {
+        json previous = json::parse(existing, nullptr, false);
+        if (!previous.is_discarded() && previous.value("version", 0) == kVersion && previous.contains("characters")) {
+            for (const json& entry : previous["characters"]) {
+                if (entry.value("name", "") != name) manifest["characters"].push_back(entry);
+            }
+        }
+    }
+    manifest["characters"].push_back(toJson(character));
+    std::ofstream out(manifestPath);
+    out << manifest.dump(2);
+    if (!out) {
+        std::cerr << "Cannot write " << manifestPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+json AssetChunks::toJson(const Character& character) {
+    auto chunkJson = [](const Chunk& chunk) { return json{{"url", chunk.url}, {"bytes", chunk.bytes}}; };
+    json textures = json::array();
+    for (const Texture& texture : character.textures) {
+        json payloads = json::array();
+        for (const Payload& payload : texture.payloads) {
+            json chunks = json::array();
+            for (const LevelChunk& levelChunk : payload.chunks) {
+                json entry = chunkJson(levelChunk.chunk);
+                entry["firstLevel"] = levelChunk.firstLevel;
+                entry["levelCount"] = levelChunk.levelCount;
+                chunks.push_back(entry);
+            }
+            payloads.push_back({{"format", (uint32_t)payload.format}, {"chunks", chunks}});
+        }
+        textures.push_back({{"name", texture.name}, {"width", texture.width}, {"height", texture.height},
+                            {"levelCount", texture.levelCount}, {"payloads", payloads}});
+    }
+    return {{"name", character.name}, {"core", chunkJson(character.core)}, {"meshes", chunkJson(character.meshes)},
+            {"textures", textures}};
+}
+
+bool AssetChunks::parseManifest(const std::string& text, Manifest& manifest) {
+    manifest = Manifest();
+    json j = json::parse(text, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) {
+        std::cerr << "Manifest is not valid JSON" << std::endl;
+        return false;
+    }
+    if (j.value("version", 0) != kVersion) {
+        std::cerr << "Manifest has version " << j.value("version", 0) << ", expected " << kVersion << "; rebake it" << std::endl;
+        return false;
+    }
+    auto readChunk = [](const json& item) {
+        Chunk chunk;
+        chunk.url = item.value("url", "");
+        chunk.bytes = item.value("bytes", (size_t)0);
+        return chunk;
+    };
+    for (const json& item : j.value("characters", json::array())) {
+        Character character;
+        character.name = item.value("name", "");
+        character.core = readChunk(item.value("core", json::object()));
+        character.meshes = readChunk(item.value("meshes", json::object()));
+        for (const json& textureItem : item.value("textures", json::array())) {
+            Texture texture;
+            texture.name = textureItem.value("name", "");
+            texture.width = textureItem.value("width", 0);
+            texture.height = textureItem.value("height", 0);
+            texture.levelCount = textureItem.value("levelCount", 0u);
+            for (const json& payloadItem : textureItem.value("payloads", json::array())) {
+                uint32_t format = payloadItem.value("format", 0u);
+                if (format > (uint32_t)CharacterAsset::TextureFormat::ETC2_RGBA8) continue;
+                Payload payload;
+                payload.format = (CharacterAsset::TextureFormat)format;
+                for (const json& chunkItem : payloadItem.value("chunks", json::array())) {
+                    LevelChunk levelChunk;
+                    levelChunk.chunk = readChunk(chunkItem);
+                    levelChunk.firstLevel = chunkItem.value("firstLevel", 0u);
+                    levelChunk.levelCount = chunkItem.value("levelCount", 0u);
+                    payload.chunks.push_back(levelChunk);
+                }
+                texture.payloads.push_back(std::move(payload));
+            }
+            character.textures.push_back(std::move(texture));
+        }
+        manifest.characters.push_back(std::move(character));
+    }
+    return true;
+}
+
+std::vector<CharacterAsset::TextureLevel> AssetChunks::parseLevels(const Texture& texture, const Payload& payload,
+                                                                   const LevelChunk& levelChunk, const uint8_t* data, size_t size) {
+    std::vector<CharacterAsset::TextureLevel> levels;
+    if (levelChunk.firstLevel + levelChunk.levelCount > texture.levelCount) return {};
+    size_t offset = 0;
+    for (uint32_t i = levelChunk.firstLevel; i < levelChunk.firstLevel + levelChunk.levelCount; i++) {
+        CharacterAsset::TextureLevel level;
+        level.width = std::max(1, texture.width >> i);
+        level.height = std::max(1, texture.height >> i);
+        size_t bytes = TextureCompression::levelSize(payload.format, level.width, level.height);
+        if (bytes > size - offset) return {};
+        level.data.assign(data + offset, data + offset + bytes);
+        offset += bytes;
+        levels.push_back(std::move(level));
+    }
+    if (offset != size) return {};
+    return levels;
+}
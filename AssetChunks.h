@@ -0,0 +1,76 @@
+#ifndef ASSET_CHUNKS_H
+#define ASSET_CHUNKS_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "CharacterAsset.h"
+#include "AssetBaking.h"
+
+// Streaming layout of baked characters: each .character split into chunk files a runtime fetches
+// one at a time, listed in a JSON manifest (manifest.json) it boots with. Per character:
+//   core    a .character with the skeleton, clips and BakedAsset config (enough to animate)
+//   meshes  a .character with only the vertex and index buffers
+//   levels  raw payload bytes of one texture format, several mip levels per chunk. The levels up
+//           to kTailSize come first in one chunk, then every larger level on its own, coarsest
+//           first, so a texture can be sampled as soon as its first chunk arrives.
+class AssetChunks {
+public:
+    static constexpr int kVersion = 1;
+    static constexpr int kTailSize = 64;
+
+    struct Chunk {
+        std::string url;  // relative to the manifest
+        size_t bytes = 0;
+    };
+
+    struct LevelChunk {
+        Chunk chunk;
+        uint32_t firstLevel = 0;  // levels firstLevel .. firstLevel + levelCount - 1, finest first
+        uint32_t levelCount = 0;
+    };
+
+    struct Payload {
+        CharacterAsset::TextureFormat format = CharacterAsset::TextureFormat::RGBA8;
+        std::vector<LevelChunk> chunks;  // coarsest first
+    };
+
+    // Level i is max(1, width >> i) by max(1, height >> i), as TextureCompression mips them
+    struct Texture {
+        std::string name;
+        int width = 0;
+        int height = 0;
+        uint32_t levelCount = 0;
+        std::vector<Payload> payloads;  // in baked (preference) order
+    };
+
+    struct Character {
+        std::string name;
+        Chunk core;
+        Chunk meshes;
+        std::vector<Texture> textures;
+    };
+
+    struct Manifest {
+        std::vector<Character> characters;
+
+        const Character* find(const std::string& name) const;
+    };
+
+    // Writes the chunks of a baked asset into directory as <name>.*, and adds the character to
+    // directory/manifest.json, replacing an earlier entry of the same name
+    static bool write(const std::string& directory, const std::string& name, const CharacterAsset& asset,
+                      const BakedAsset& config);
+
+    // False (and logged) on malformed JSON or another manifest version
+    static bool parseManifest(const std::string& text, Manifest& manifest);
+
+    // Splits a fetched level chunk into its levels; empty if its size doesn't match the manifest
+    static std::vector<CharacterAsset::TextureLevel> parseLevels(const Texture& texture, const Payload& payload,
+                                                                 const LevelChunk& levelChunk, const uint8_t* data, size_t size);
+
+private:
+    static json toJson(const Character& character);
+};
+
+#endif
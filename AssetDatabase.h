@@ -0,0 +1,246 @@
+#ifndef ASSET_DATABASE_H
+#define ASSET_DATABASE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include "CharacterAsset.h"
+#include "CharacterAssetFile.h"
+#include "AssetBaking.h"
+
+// Process-wide registry of baked characters, keyed by .character path. Nothing loads until it is
+// first asked for; after that every request for the same path shares one copy through ref-counted
+// handles. Skeleton, mesh and clip handles alias the asset they come from, so holding any of them
+// keeps the whole asset resident. Entries no handle refers to stay cached until a budget is
+// exceeded, then the least recently used go first.
+//
+// GPU textures are uploaded and freed through a backend the renderer installs, so the database
+// has no GL dependency and the server uses it as is. texture() and trim() run the backend and
+// belong on the GL thread; character lookups may come from any thread.
+class AssetDatabase {
+public:
+    using CharacterHandle = std::shared_ptr<const CharacterAsset>;
+    using SkeletonHandle = std::shared_ptr<const Skeleton>;
+    using MeshesHandle = std::shared_ptr<const std::vector<CharacterAsset::MeshData>>;
+    using ClipHandle = std::shared_ptr<const CharacterAsset::CompiledClip>;
+
+    struct GpuTexture {
+        uint32_t id = 0;  // GLuint
+        size_t bytes = 0;
+    };
+    using TextureHandle = std::shared_ptr<const GpuTexture>;
+
+    // upload returns the texture id (0 on failure) and the bytes it occupies; release frees it
+    struct TextureBackend {
+        std::function<uint32_t(const CharacterAsset::BakedTexture& texture, size_t& bytes)> upload;
+        std::function<void(uint32_t id)> release;
+    };
+
+    struct Budget {
+        size_t cpuBytes = 0;  // 0 = unlimited
+        size_t gpuBytes = 0;
+    };
+
+    struct Counters {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t failures = 0;  // misses that couldn't load
+    };
+
+    struct Stats {
+        Counters characters;
+        Counters textures;
+        size_t cpuBytes = 0;  // resident, referenced or not
+        size_t gpuBytes = 0;
+        size_t residentCharacters = 0;
+        size_t residentTextures = 0;
+    };
+
+    static AssetDatabase& instance() {
+        static AssetDatabase database;
+        return database;
+    }
+
+    // Evicts right away if the new budget is already exceeded
+    void setBudget(const Budget& newBudget) {
+        std::lock_guard<std::mutex> lock(mutex);
+        budget = newBudget;
+        trimCharacters();
+        trimTextures();
+    }
+
+    void setTextureBackend(TextureBackend newBackend) {
+        std::lock_guard<std::mutex> lock(mutex);
+        backend = std::move(newBackend);
+    }
+
+    // nullptr if the file can't be loaded; the next request tries again. config, if given,
+    // receives the BakedAsset stored with it.
+    CharacterHandle character(const std::string& path, BakedAsset* config = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        CharacterHandle handle = acquireCharacter(path, config);
+        trimCharacters();
+        return handle;
+    }
+
+    SkeletonHandle skeleton(const std::string& path) {
+        CharacterHandle asset = character(path);
+        return asset ? SkeletonHandle(asset, &asset->getSkeleton()) : nullptr;
+    }
+
+    MeshesHandle meshes(const std::string& path) {
+        CharacterHandle asset = character(path);
+        return asset ? MeshesHandle(asset, &asset->getMeshes()) : nullptr;
+    }
+
+    // nullptr if the asset doesn't load or has no such clip
+    ClipHandle clip(const std::string& path, int index) {
+        CharacterHandle asset = character(path);
+        if (!asset || index < 0 || index >= (int)asset->getClips().size()) return nullptr;
+        return ClipHandle(asset, &asset->getClips()[index]);
+    }
+
+    // GPU texture for a mesh texture path baked into the asset. nullptr without a backend, if the
+    // texture wasn't baked or if no payload could be uploaded.
+    TextureHandle texture(const std::string& path, const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto key = std::make_pair(path, name);
+        auto it = textures.find(key);
+        if (it != textures.end()) {
+            stats.textures.hits++;
+            it->second.lastUse = ++useClock;
+            return it->second.texture;
+        }
+        stats.textures.misses++;
+
+        // The source asset only has to stay resident for the upload
+        CharacterHandle asset = backend.upload ? acquireCharacter(path, nullptr) : nullptr;
+        const CharacterAsset::BakedTexture* baked = asset ? asset->findBakedTexture(name) : nullptr;
+        size_t bytes = 0;
+        uint32_t id = baked ? backend.upload(*baked, bytes) : 0;
+        if (id == 0) {
+            stats.textures.failures++;
+            return nullptr;
+        }
+        TextureHandle handle = std::make_shared<const GpuTexture>(GpuTexture{id, bytes});
+        textures[key] = {handle, ++useClock};
+        stats.gpuBytes += bytes;
+        trimTextures();
+        trimCharacters();
+        return handle;
+    }
+
+    // Evicts down to the budget, e.g. after despawning characters
+    void trim() {
+        std::lock_guard<std::mutex> lock(mutex);
+        trimCharacters();
+        trimTextures();
+    }
+
+    // Drops every entry no handle refers to, whatever the budget
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (evictCharacter()) {}
+        while (evictTexture()) {}
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats current = stats;
+        current.residentCharacters = characters.size();
+        current.residentTextures = textures.size();
+        return current;
+    }
+
+private:
+    struct CharacterEntry {
+        CharacterHandle asset;
+        BakedAsset config;
+        size_t bytes = 0;
+        uint64_t lastUse = 0;
+    };
+
+    struct TextureEntry {
+        TextureHandle texture;
+        uint64_t lastUse = 0;
+    };
+
+    CharacterHandle acquireCharacter(const std::string& path, BakedAsset* config) {
+        auto it = characters.find(path);
+        if (it != characters.end()) {
+            stats.characters.hits++;
+            it->second.lastUse = ++useClock;
+            if (config) *config = it->second.config;
+            return it->second.asset;
+        }
+        stats.characters.misses++;
+
+        CharacterEntry entry;
+        std::shared_ptr<CharacterAsset> loaded = CharacterAssetFile::load(path, &entry.config);
+        if (!loaded) {
+            stats.characters.failures++;
+            return nullptr;
+        }
+        entry.bytes = loaded->sizeInBytes();
+        entry.asset = std::move(loaded);
+        entry.lastUse = ++useClock;
+        stats.cpuBytes += entry.bytes;
+        if (config) *config = entry.config;
+        CharacterHandle handle = entry.asset;  // referenced, so the trim that follows can't evict it
+        characters[path] = std::move(entry);
+        return handle;
+    }
+
+    // Least recently used entry the database holds the only reference to
+    bool evictCharacter() {
+        auto victim = characters.end();
+        for (auto it = characters.begin(); it != characters.end(); ++it) {
+            if (it->second.asset.use_count() != 1) continue;
+            if (victim == characters.end() || it->second.lastUse < victim->second.lastUse) victim = it;
+        }
+        if (victim == characters.end()) return false;
+        stats.cpuBytes -= victim->second.bytes;
+        stats.characters.evictions++;
+        characters.erase(victim);
+        return true;
+    }
+
+    bool evictTexture() {
+        auto victim = textures.end();
+        for (auto it = textures.begin(); it != textures.end(); ++it) {
+            if (it->second.texture.use_count() != 1) continue;
+            if (victim == textures.end() || it->second.lastUse < victim->second.lastUse) victim = it;
+        }
+        if (victim == textures.end()) return false;
+        stats.gpuBytes -= victim->second.texture->bytes;
+        stats.textures.evictions++;
+        if (backend.release) backend.release(victim->second.texture->id);
+        textures.erase(victim);
+        return true;
+    }
+
+    // Stops early when everything left is in use; the budget is a target, not a hard limit
+    void trimCharacters() {
+        while (budget.cpuBytes > 0 && stats.cpuBytes > budget.cpuBytes && evictCharacter()) {}
+    }
+
+    void trimTextures() {
+        while (budget.gpuBytes > 0 && stats.gpuBytes > budget.gpuBytes && evictTexture()) {}
+    }
+
+    mutable std::mutex mutex;
+    std::map<std::string, CharacterEntry> characters;
+    std::map<std::pair<std::string, std::string>, TextureEntry> textures;
+    TextureBackend backend;
+    Budget budget;
+    Stats stats;
+    uint64_t useClock = 0;
+};
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef CAPSULE_RAYCAST_H
+#define CAPSULE_RAYCAST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "SimdMath.h"
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float maxDistance;
+};
+
+// Capsules as parallel arrays of world-space endpoints and radii
+struct CapsuleSoA {
+    const float* startX;
+    const float* startY;
+    const float* startZ;
+    const float* endX;
+    const float* endY;
+    const float* endZ;
+    const float* radius;
+    size_t count;
+};
+
+// Ray vs capsule tests. nearest() runs kWidth capsules per step with the instruction set SimdMath
+// was built for (8 with AVX2, 4 with SSE2 or WASM SIMD128) and the rest one at a time; every lane
+// does the same float operations as intersect(), so both agree on which capsule is hit.
+class CapsuleRaycast {
+public:
+#if SIMD_MATH_AVX2
+    static constexpr size_t kWidth = 8;
+#elif SIMD_MATH_SSE || SIMD_MATH_WASM
+    static constexpr size_t kWidth = 4;
+#else
+    static constexpr size_t kWidth = 1;
+#endif
+
+    // Ray parameter t >= 0 of the first surface crossing. Crossings behind the origin don't count:
+    // a capsule behind the ray is missed, and so is one the ray starts inside (its shooter's own,
+    // say), since the capsule is convex and its entry lies behind.
+    static bool intersect(glm::vec3 ro, glm::vec3 rd, glm::vec3 a, glm::vec3 b, float r, float& t) {
+        glm::vec3 ba = b - a;
+        glm::vec3 oa = ro - a;
+        float baba = glm::dot(ba, ba);
+        float bard = glm::dot(ba, rd);
+        float baoa = glm::dot(ba, oa);
+        float rdoa = glm::dot(rd, oa);
+        float oaoa = glm::dot(oa, oa);
+
+        float a_coeff = baba - bard * bard;
+        float b_coeff = baba * rdoa - baoa * bard;
+        float c_coeff = baba * oaoa - baoa * baoa - r * r * baba;
+        float h = b_coeff * b_coeff - a_coeff * c_coeff;
+        if (h >= 0.0f) {
+            t = (-b_coeff - std::sqrt(h)) / a_coeff;
+            float y = baoa + t * bard;
+            if (y > 0.0f && y < baba) return t >= 0.0f;
+            // Cap intersections
+            glm::vec3 oc = (y <= 0.0f) ? oa : ro - b;
+            b_coeff = glm::dot(rd, oc);
+            c_coeff = glm::dot(oc, oc) - r * r;
+            h = b_coeff * b_coeff - c_coeff;
+            if (h >= 0.0f) {
+                t = -b_coeff - std::sqrt(h);
+                return t >= 0.0f;
+            }
+        }
+        return false;
+    }
+
+    // Index of the capsule hit closest to the origin with 0 <= t < ray.maxDistance, or -1. Ties
+    // go to the lower index.
+    static int nearest(const Ray& ray, const CapsuleSoA& capsules, float& t) {
+        float best = ray.maxDistance;
+        int bestIndex = -1;
+        size_t i = 0;
+#if !SIMD_MATH_SCALAR
+        const Lanes rox = Lanes::splat(ray.origin.x), roy = Lanes::splat(ray.origin.y), roz = Lanes::splat(ray.origin.z);
+        const Lanes rdx = Lanes::splat(ray.direction.x), rdy = Lanes::splat(ray.direction.y), rdz = Lanes::splat(ray.direction.z);
+        const Lanes zero = Lanes::splat(0.0f);
+        for (; i + kWidth <= capsules.count; i += kWidth) {
+            Lanes ax = Lanes::load(capsules.startX + i), ay = Lanes::load(capsules.startY + i), az = Lanes::load(capsules.startZ + i);
+            Lanes bx = Lanes::load(capsules.endX + i), by = Lanes::load(capsules.endY + i), bz = Lanes::load(capsules.endZ + i);
+            Lanes r = Lanes::load(capsules.radius + i);
+
+            Lanes bax = bx - ax, bay = by - ay, baz = bz - az;
+            Lanes oax = rox - ax, oay = roy - ay, oaz = roz - az;
+            Lanes baba = bax * bax + bay * bay + baz * baz;
+            Lanes bard = bax * rdx + bay * rdy + baz * rdz;
+            Lanes baoa = bax * oax + bay * oay + baz * oaz;
+            Lanes rdoa = rdx * oax + rdy * oay + rdz * oaz;
+            Lanes oaoa = oax * oax + oay * oay + oaz * oaz;
+
+            Lanes aCoeff = baba - bard * bard;
+            Lanes bCoeff = baba * rdoa - baoa * bard;
+            Lanes cCoeff = baba * oaoa - baoa * baoa - r * r * baba;
+            Lanes h = bCoeff * bCoeff - aCoeff * cCoeff;
+            Lanes hasRoot = h >= zero;
+            if (!hasRoot.any()) continue;
+
+            Lanes bodyT = (-bCoeff - h.sqrt()) / aCoeff;
+            Lanes y = baoa + bodyT * bard;
+            Lanes body = (y > zero) & (y < baba);
+            Lanes below = y <= zero;
+            Lanes ocx = Lanes::select(below, oax, rox - bx);
+            Lanes ocy = Lanes::select(below, oay, roy - by);
+            Lanes ocz = Lanes::select(below, oaz, roz - bz);
+            Lanes capB = rdx * ocx + rdy * ocy + rdz * ocz;
+            Lanes capC = ocx * ocx + ocy * ocy + ocz * ocz - r * r;
+            Lanes capH = capB * capB - capC;
+            Lanes capT = -capB - capH.sqrt();
+
+            Lanes laneT = Lanes::select(body, bodyT, capT);
+            Lanes hit = hasRoot & (body | (capH >= zero)) & (laneT >= zero) & (laneT < Lanes::splat(best));
+            if (!hit.any()) continue;
+            // Hits are rare; settle the closest of this group in lane order, as the scalar loop would
+            alignas(32) float lanesT[kWidth];
+            laneT.store(lanesT);
+            int hitBits = hit.bits();
+            for (size_t lane = 0; lane < kWidth; lane++) {
+                if ((hitBits >> lane & 1) && lanesT[lane] < best) {
+                    best = lanesT[lane];
+                    bestIndex = (int)(i + lane);
+                }
+            }
+        }
+#endif
+        for (; i < capsules.count; i++) {
+            float laneT;
+            if (intersectAt(ray, capsules, i, laneT) && laneT < best) {
+                best = laneT;
+                bestIndex = (int)i;
+            }
+        }
+        t = best;
+        return bestIndex;
+    }
+
+    // nearest() without the SIMD path, as a reference
+    static int nearestScalar(const Ray& ray, const CapsuleSoA& capsules, float& t) {
+        float best = ray.maxDistance;
+        int bestIndex = -1;
+        for (size_t i = 0; i < capsules.count; i++) {
+            float laneT;
+            if (intersectAt(ray, capsules, i, laneT) && laneT < best) {
+                best = laneT;
+                bestIndex = (int)i;
+            }
+        }
+        t = best;
+        return bestIndex;
+    }
+
+private:
+    static bool intersectAt(const Ray& ray, const CapsuleSoA& capsules, size_t i, float& t) {
+        return intersect(ray.origin, ray.direction, glm::vec3(capsules.startX[i], capsules.startY[i], capsules.startZ[i]),
+                         glm::vec3(capsules.endX[i], capsules.endY[i], capsules.endZ[i]), capsules.radius[i], t);
+    }
+
+    // kWidth floats; comparisons return all-ones/all-zeros lane masks. No FMA, so each lane rounds
+    // like the scalar code.
+#if SIMD_MATH_AVX2
+    struct Lanes {
+        __m256 v;
+        static Lanes load(const float* p) { return {_mm256_loadu_ps(p)}; }
+        static Lanes splat(float f) { return {_mm256_set1_ps(f)}; }
+        static Lanes select(Lanes mask, Lanes a, Lanes b) { return {_mm256_blendv_ps(b.v, a.v, mask.v)}; }
+        void store(float* p) const { _mm256_storeu_ps(p, v); }
+        Lanes sqrt() const { return {_mm256_sqrt_ps(v)}; }
+        int bits() const { return _mm256_movemask_ps(v); }
+        bool any() const { return bits() != 0; }
+        Lanes operator-() const { return {_mm256_xor_ps(v, _mm256_set1_ps(-0.0f))}; }
+        Lanes operator+(Lanes o) const { return {_mm256_add_ps(v, o.v)}; }
+        Lanes operator-(Lanes o) const { return {_mm256_sub_ps(v, o.v)}; }
+        Lanes operator*(Lanes o) const { return {_mm256_mul_ps(v, o.v)}; }
+        Lanes operator/(Lanes o) const { return {_mm256_div_ps(v, o.v)}; }
+        Lanes operator&(Lanes o) const { return {_mm256_and_ps(v, o.v)}; }
+        Lanes operator|(Lanes o) const { return {_mm256_or_ps(v, o.v)}; }
+        Lanes operator<(Lanes o) const { return {_mm256_cmp_ps(v, o.v, _CMP_LT_OQ)}; }
+        Lanes operator<=(Lanes o) const { return {_mm256_cmp_ps(v, o.v, _CMP_LE_OQ)}; }
+        Lanes operator>(Lanes o) const { return {_mm256_cmp_ps(v, o.v, _CMP_GT_OQ)}; }
+        Lanes operator>=(Lanes o) const { return {_mm256_cmp_ps(v, o.v, _CMP_GE_OQ)}; }
+    };
+#elif SIMD_MATH_SSE
+    struct Lanes {
+        __m128 v;
+        static Lanes load(const float* p) { return {_mm_loadu_ps(p)}; }
+        static Lanes splat(float f) { return {_mm_set1_ps(f)}; }
+        static Lanes select(Lanes mask, Lanes a, Lanes b) { return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))}; }
+        void store(float* p) const { _mm_storeu_ps(p, v); }
+        Lanes sqrt() const { return {_mm_sqrt_ps(v)}; }
+        int bits() const { return _mm_movemask_ps(v); }
+        bool any() const { return bits() != 0; }
+        Lanes operator-() const { return {_mm_xor_ps(v, _mm_set1_ps(-0.0f))}; }
+        Lanes operator+(Lanes o) const { return {_mm_add_ps(v, o.v)}; }
+        Lanes operator-(Lanes o) const { return {_mm_sub_ps(v, o.v)}; }
+        Lanes operator*(Lanes o) const { return {_mm_mul_ps(v, o.v)}; }
+        Lanes operator/(Lanes o) const { return {_mm_div_ps(v, o.v)}; }
+        Lanes operator&(Lanes o) const { return {_mm_and_ps(v, o.v)}; }
+        Lanes operator|(Lanes o) const { return {_mm_or_ps(v, o.v)}; }
+        Lanes operator<(Lanes o) const { return {_mm_cmplt_ps(v, o.v)}; }
+        Lanes operator<=(Lanes o) const { return {_mm_cmple_ps(v, o.v)}; }
+        Lanes operator>(Lanes o) const { return {_mm_cmpgt_ps(v, o.v)}; }
+        Lanes operator>=(Lanes o) const { return {_mm_cmpge_ps(v, o.v)}; }
+    };
+#elif SIMD_MATH_WASM
+    struct Lanes {
+        v128_t v;
+        static Lanes load(const float* p) { return {wasm_v128_load(p)}; }
+        static Lanes splat(float f) { return {wasm_f32x4_splat(f)}; }
+        static Lanes select(Lanes mask, Lanes a, Lanes b) { return {wasm_v128_bitselect(a.v, b.v, mask.v)}; }
+        void store(float* p) const { wasm_v128_store(p, v); }
+        Lanes sqrt() const { return {wasm_f32x4_sqrt(v)}; }
+        int bits() const { return (int)wasm_i32x4_bitmask(v); }
+        bool any() const { return wasm_v128_any_true(v); }
+        Lanes operator-() const { return {wasm_f32x4_neg(v)}; }
+        Lanes operator+(Lanes o) const { return {wasm_f32x4_add(v, o.v)}; }
+        Lanes operator-(Lanes o) const { return {wasm_f32x4_sub(v, o.v)}; }
+        Lanes operator*(Lanes o) const { return {wasm_f32x4_mul(v, o.v)}; }
+        Lanes operator/(Lanes o) const { return {wasm_f32x4_div(v, o.v)}; }
+        Lanes operator&(Lanes o) const { return {wasm_v128_and(v, o.v)}; }
+        Lanes operator|(Lanes o) const { return {wasm_v128_or(v, o.v)}; }
+        Lanes operator<(Lanes o) const { return {wasm_f32x4_lt(v, o.v)}; }
+        Lanes operator<=(Lanes o) const { return {wasm_f32x4_le(v, o.v)}; }
+        Lanes operator>(Lanes o) const { return {wasm_f32x4_gt(v, o.v)}; }
+        Lanes operator>=(Lanes o) const { return {wasm_f32x4_ge(v, o.v)}; }
+    };
+#endif
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "CharacterAsset.h"
+#include "MeshOptimizer.h"
+#include "JobSystem.h"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+
+static glm::vec3 interpolateKeys(const std::vector<VectorKey>& keys, float animationTime, unsigned int& cursor, const glm::vec3& fallback) {
+    if (keys.empty()) return fallback;
+    if (keys.size() == 1) return keys[0].value;
+    unsigned int i = findKeySegment(animationTime, (unsigned int)keys.size(), cursor, [&keys](unsigned int k) { return keys[k].time; });
+    float factor = keySegmentFactor(animationTime, keys[i].time, keys[i + 1].time);
+    return glm::mix(keys[i].value, keys[i + 1].value, factor);
+}
+
+static glm::quat interpolateKeys(const std::vector<RotationKey>& keys, float animationTime, unsigned int& cursor, const glm::quat& fallback) {
+    if (keys.empty()) return fallback;
+    if (keys.size() == 1) return keys[0].value;
+    unsigned int i = findKeySegment(animationTime, (unsigned int)keys.size(), cursor, [&keys](unsigned int k) { return keys[k].time; });
+    float factor = keySegmentFactor(animationTime, keys[i].time, keys[i + 1].time);
+    return glm::normalize(glm::slerp(keys[i].value, keys[i + 1].value, factor));
+}
+
+std::shared_ptr<CharacterAsset> CharacterAsset::fromAnimation(Skeleton skeleton, std::vector<CompiledClip> clips) {
+    auto asset = std::make_shared<CharacterAsset>();
+    asset->skeleton = std::move(skeleton);
+    asset->clips = std::move(clips);
+    return asset;
+}
+
+std::vector<CompressionReport> CharacterAsset::compressClips(const CompressionSettings& settings, JobSystem* jobs) {
+    // Clips are independent; each task writes only its own clip and report slot
+    std::vector<CompressionReport> clipReports(clips.size());
+    std::vector<char> compressedNow(clips.size(), 0);
+    auto compressRange = [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            CompiledClip& clip = clips[c];
+            // Clips loaded from a baked file only carry their compressed form
+            if (clip.isCompressed && clip.channels.empty()) continue;
+            CompressionReport& report = clipReports[c];
+            report.clipName = clip.name;
+
+            CompressedClip& compressed = clip.compressed;
+            compressed = CompressedClip();
+            compressed.duration = clip.duration;
+            compressed.channelForBone.assign(skeleton.size(), -1);
+            for (size_t bone = 0; bone < skeleton.size(); bone++) {
+                int channel = clip.channelForBone[bone];
+                if (channel < 0) continue;
+                const RawChannel& raw = clip.channels[channel];
+                compressed.channelForBone[bone] = (int)compressed.channels.size();
+                compressed.channels.push_back(ClipCompression::compressChannel(
+                        raw.positions.data(), (unsigned int)raw.positions.size(),
+                        raw.rotations.data(), (unsigned int)raw.rotations.size(),
+                        raw.scalings.data(), (unsigned int)raw.scalings.size(),
+                        compressed.duration, settings, report));
+            }
+            clip.isCompressed = true;
+            clip.baked = BakedPalettes();
+            compressedNow[c] = 1;
+        }
+    };
+    if (jobs) jobs->parallelFor(clips.size(), 1, compressRange);
+    else compressRange(0, clips.size());
+
+    std::vector<CompressionReport> reports;
+    for (size_t c = 0; c < clips.size(); c++) {
+        if (compressedNow[c]) reports.push_back(std::move(clipReports[c]));
+    }
+    return reports;
+}
+
+std::vector<MeshOptimizationReport> CharacterAsset::optimizeMeshes(JobSystem* jobs) {
+    std::vector<MeshOptimizationReport> reports(meshes.size());
+    auto optimizeRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) reports[i] = MeshOptimizer::optimize(meshes[i]);
+    };
+    if (jobs) jobs->parallelFor(meshes.size(), 1, optimizeRange);
+    else optimizeRange(0, meshes.size());
+    return reports;
+}
+
+const CharacterAsset::EmbeddedTexture* CharacterAsset::getEmbeddedTexture(const std::string& path) const {
+    if (path.size() < 2 || path[0] != '*') return nullptr;
+    int index = std::atoi(path.c_str() + 1);
+    if (index < 0 || index >= (int)textures.size()) return nullptr;
+    return &textures[index];
+}
+
+size_t CharacterAsset::TexturePayload::sizeInBytes() const {
+    size_t bytes = 0;
+    for (const TextureLevel& level : levels) bytes += level.data.size();
+    return bytes;
+}
+
+const CharacterAsset::TexturePayload* CharacterAsset::BakedTexture::findPayload(TextureFormat format) const {
+    for (const TexturePayload& payload : payloads) {
+        if (payload.format == format) return &payload;
+    }
+    return nullptr;
+}
+
+const CharacterAsset::BakedTexture* CharacterAsset::findBakedTexture(const std::string& name) const {
+    for (const BakedTexture& texture : bakedTextures) {
+        if (texture.name == name) return &texture;
+    }
+    return nullptr;
+}
+
+PaletteBakeReport CharacterAsset::bakePalettes(int clipIndex, float framesPerSecond) {
+    using Clock = std::chrono::steady_clock;
+    PaletteBakeReport report;
+    if (clipIndex < 0 || clipIndex >= (int)clips.size() || framesPerSecond <= 0.0f) return report;
+    CompiledClip& clip = clips[clipIndex];
+    report.clipName = clip.name;
+
+    // Whole number of frames per loop, so the wrap from the last frame to the first is exact
+    size_t boneCount = skeleton.size();
+    float duration = clip.duration / clip.ticksPerSecond;
+    BakedPalettes baked;
+    baked.frameCount = std::max<size_t>(1, (size_t)std::lround(duration * framesPerSecond));
+    baked.frameDuration = duration / baked.frameCount;
+    baked.palettes.resize(baked.frameCount * boneCount);
+    baked.worldTransforms.resize(baked.frameCount * boneCount);
+
+    std::vector<KeyCursor> cursors(boneCount);
+    std::vector<BoneTransform> pose(boneCount);
+    auto start = Clock::now();
+    for (size_t f = 0; f < baked.frameCount; f++) {
+        sampleClip(f * baked.frameDuration * clip.ticksPerSecond, &clip, cursors.data(), pose.data());
+        skeleton.evaluate(pose.data(), &baked.worldTransforms[f * boneCount], &baked.palettes[f * boneCount]);
+    }
+    double sampledNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    // Playback cost, measured halfway between frames so every update interpolates
+    std::vector<glm::mat4> world(boneCount), palette(boneCount);
+    start = Clock::now();
+    for (size_t f = 0; f < baked.frameCount; f++) {
+        baked.sample((f + 0.5f) * baked.frameDuration, true, boneCount, world.data(), palette.data());
+    }
+    double bakedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    report.frameCount = baked.frameCount;
+    report.bytes = baked.sizeInBytes();
+    report.sampledNsPerUpdate = sampledNs / baked.frameCount;
+    report.bakedNsPerUpdate = bakedNs / baked.frameCount;
+    clip.baked = std::move(baked);
+    return report;
+}
+
+void CharacterAsset::BakedPalettes::sample(float timeSeconds, bool interpolate, size_t boneCount, glm::mat4* world, glm::mat4* palette) const {
+    float position = frameDuration > 0.0f ? timeSeconds / frameDuration : 0.0f;
+    size_t f0 = std::min((size_t)position, frameCount - 1);
+    float t = std::clamp(position - (float)f0, 0.0f, 1.0f);
+    if (!interpolate) {
+        if (t >= 0.5f) f0 = (f0 + 1) % frameCount;
+        std::copy_n(&worldTransforms[f0 * boneCount], boneCount, world);
+        std::copy_n(&palettes[f0 * boneCount], boneCount, palette);
+        return;
+    }
+    size_t f1 = (f0 + 1) % frameCount;
+    SimdMath::lerp(&worldTransforms[f0 * boneCount], &worldTransforms[f1 * boneCount], t, world, boneCount);
+    SimdMath::lerp(&palettes[f0 * boneCount], &palettes[f1 * boneCount], t, palette, boneCount);
+}
+
+CharacterAsset::Metadata CharacterAsset::getMetadata() const {
+    Metadata meta;
+    meta.numAnimations = (int)clips.size();
+    meta.numMeshes = (int)meshes.size();
+    meta.numBones = (int)skeleton.size();
+    for (const CompiledClip& clip : clips) meta.animationNames.push_back(clip.name);
+    return meta;
+}
+
+size_t CharacterAsset::sizeInBytes() const {
+    size_t bytes = skeleton.size() * (sizeof(glm::mat4) + sizeof(BoneTransform) + sizeof(int));
+    for (const MeshData& mesh : meshes) bytes += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * mesh.indices.elementSize();
+    for (const CompiledClip& clip : clips) {
+        for (const RawChannel& channel : clip.channels) {
+            bytes += (channel.positions.size() + channel.scalings.size()) * sizeof(VectorKey) + channel.rotations.size() * sizeof(RotationKey);
+        }
+        for (const CompressedChannel& channel : clip.compressed.channels) {
+            bytes += (channel.translation.times.size() + channel.translation.values.size() + channel.rotation.times.size() +
+                      channel.rotation.values.size() + channel.scale.times.size() + channel.scale.values.size()) * sizeof(uint16_t);
+        }
+        bytes += clip.baked.sizeInBytes();
+    }
+    for (const EmbeddedTexture& texture : textures) bytes += texture.data.size();
+    for (const BakedTexture& texture : bakedTextures) {
+        for (const TexturePayload& payload : texture.payloads) bytes += payload.sizeInBytes();
+    }
+    return bytes;
+}
+
+void CharacterAsset::sampleClip(float animationTime, const CompiledClip* clip, KeyCursor* cursors, BoneTransform* out,
+                                const int* boneIndices, size_t boneIndexCount) const {
+    size_t count = boneIndices ? boneIndexCount : skeleton.size();
+    if (clip && clip->isCompressed) {
+        const CompressedClip& compressed = clip->compressed;
+        float quantizedTime = compressed.duration > 0.0f ? animationTime * (ClipCompression::kTimeScale / compressed.duration) : 0.0f;
+        for (size_t n = 0; n < count; n++) {
+            size_t i = boneIndices ? boneIndices[n] : n;
+            int channel = compressed.channelForBone[i];
+            if (channel < 0) out[i] = skeleton.bindPose[i];
+            else ClipCompression::sampleChannel(compressed.channels[channel], quantizedTime, cursors[i], skeleton.bindPose[i], out[i]);
+        }
+        return;
+    }
+
+    for (size_t n = 0; n < count; n++) {
+        size_t i = boneIndices ? boneIndices[n] : n;
+        int channel = clip ? clip->channelForBone[i] : -1;
+        if (channel < 0) {
+            out[i] = skeleton.bindPose[i];
+            continue;
+        }
+        const RawChannel& raw = clip->channels[channel];
+        const BoneTransform& bind = skeleton.bindPose[i];
+        KeyCursor& cursor = cursors[i];
+        out[i].translation = interpolateKeys(raw.positions, animationTime, cursor.position, bind.translation);
+        out[i].rotation = interpolateKeys(raw.rotations, animationTime, cursor.rotation, bind.rotation);
+        out[i].scale = interpolateKeys(raw.scalings, animationTime, cursor.scaling, bind.scale);
+    }
+}
@@ -0,0 +1,223 @@
+#ifndef CHARACTER_ASSET_H
+#define CHARACTER_ASSET_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "Skeleton.h"
+#include "AnimationClip.h"
+
+class JobSystem;
+
+struct PaletteBakeReport {
+    std::string clipName;
+    size_t frameCount = 0;
+    size_t bytes = 0;
+    double sampledNsPerUpdate = 0.0;  // sampling + hierarchy evaluation, per instance
+    double bakedNsPerUpdate = 0.0;    // interpolated baked playback, per instance
+};
+
+struct MeshOptimizationReport {
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    float acmrBefore = 0.0f;  // vertex shader runs per triangle
+    float acmrAfter = 0.0f;
+    float atvrBefore = 0.0f;  // vertex shader runs per referenced vertex, 1.0 is ideal
+    float atvrAfter = 0.0f;
+};
+
+// Immutable skeleton + meshes + clips for one character type, loaded once and shared by every
+// FBXStateMachine instance that animates it. Anything that mutates it (compressClips) must
+// happen before it is handed out to instances. Filled in by FBXImporter (tools) or
+// CharacterAssetFile (baked binary, runtime); this class itself doesn't depend on Assimp.
+class CharacterAsset {
+public:
+    // Packed skinned vertex, 24 bytes. UVs are unorm16 over the mesh's uvOffset/uvScale range;
+    // bone ids fit in a byte (256 bones max) and weights are unorm8 summing to 255.
+    struct Vertex {
+        glm::vec3 position;
+        uint16_t uv[2];
+        uint8_t boneIds[4];
+        uint8_t weights[4];
+    };
+
+    static constexpr float kWeightScale = 1.0f / 255.0f;
+    static constexpr float kUVScale = 1.0f / 65535.0f;
+
+    // Triangle list stored 16-bit whenever every index fits, which halves its size and fetch cost.
+    // 0xFFFF is left unused since WebGL 2 always treats it as a primitive restart.
+    struct IndexBuffer {
+        std::vector<uint16_t> shortIndices;
+        std::vector<uint32_t> longIndices;
+
+        static bool fitsShort(size_t vertexCount) { return vertexCount <= 0xFFFF; }
+
+        void assign(const std::vector<uint32_t>& indices, size_t vertexCount) {
+            shortIndices.clear();
+            longIndices.clear();
+            if (fitsShort(vertexCount)) shortIndices.assign(indices.begin(), indices.end());
+            else longIndices = indices;
+        }
+
+        bool isShort() const { return longIndices.empty(); }
+        size_t size() const { return isShort() ? shortIndices.size() : longIndices.size(); }
+        size_t elementSize() const { return isShort() ? sizeof(uint16_t) : sizeof(uint32_t); }
+        const void* data() const { return isShort() ? (const void*)shortIndices.data() : (const void*)longIndices.data(); }
+        uint32_t operator[](size_t i) const { return isShort() ? shortIndices[i] : longIndices[i]; }
+        std::vector<uint32_t> toVector() const {
+            return isShort() ? std::vector<uint32_t>(shortIndices.begin(), shortIndices.end()) : longIndices;
+        }
+    };
+
+    struct MeshData {
+        std::vector<Vertex> vertices;
+        IndexBuffer indices;
+        std::string texturePath;
+        glm::vec2 uvOffset = glm::vec2(0.0f);
+        glm::vec2 uvScale = glm::vec2(1.0f);
+
+        glm::vec2 getUV(const Vertex& vertex) const {
+            return uvOffset + uvScale * (glm::vec2(vertex.uv[0], vertex.uv[1]) * kUVScale);
+        }
+    };
+
+    // Texture stored inside the source file, referenced by meshes as "*<index>". height 0 means
+    // data holds an encoded image (PNG, JPG, ...) of width bytes; otherwise width * height BGRA texels.
+    struct EmbeddedTexture {
+        std::string path;
+        std::string formatHint;
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> data;
+    };
+
+    // GPU encodings a baked texture can carry. BC1/ETC2_RGB8 for opaque images, BC3/ETC2_RGBA8
+    // when there is alpha; RGBA8 is the uncompressed fallback every device can sample.
+    enum class TextureFormat : uint32_t { RGBA8 = 0, BC1, BC3, ETC2_RGB8, ETC2_RGBA8 };
+
+    struct TextureLevel {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> data;
+    };
+
+    struct TexturePayload {
+        TextureFormat format = TextureFormat::RGBA8;
+        std::vector<TextureLevel> levels;  // full size down to 1x1
+
+        size_t sizeInBytes() const;
+    };
+
+    // Texture resolved and encoded at bake time, named by the texturePath meshes reference it with.
+    // Rows are bottom-up, as GL expects; the runtime uploads one payload level by level.
+    struct BakedTexture {
+        std::string name;
+        int width = 0;
+        int height = 0;
+        std::vector<TexturePayload> payloads;
+
+        const TexturePayload* findPayload(TextureFormat format) const;
+    };
+
+    struct Metadata {
+        int numAnimations = 0;
+        int numMeshes = 0;
+        int numBones = 0;
+        std::vector<std::string> animationNames;
+    };
+
+    // Skinning palettes (and world transforms, for hit tests and debug draw) precomputed at a
+    // fixed rate over one loop of a clip. Frame f holds the pose at f * frameDuration seconds
+    // and the last frame interpolates back into the first.
+    struct BakedPalettes {
+        size_t frameCount = 0;
+        float frameDuration = 0.0f;  // seconds
+        std::vector<glm::mat4> palettes;         // frameCount * boneCount
+        std::vector<glm::mat4> worldTransforms;  // frameCount * boneCount
+
+        bool empty() const { return frameCount == 0; }
+        size_t sizeInBytes() const { return (palettes.size() + worldTransforms.size()) * sizeof(glm::mat4); }
+
+        // Writes the pose at timeSeconds, either the nearest frame or a component-wise lerp of
+        // the two surrounding ones
+        void sample(float timeSeconds, bool interpolate, size_t boneCount, glm::mat4* world, glm::mat4* palette) const;
+    };
+
+    // Animation bound to the skeleton. channelForBone[boneIndex] indexes channels, or is -1 if
+    // the clip doesn't animate that bone (bind pose).
+    struct CompiledClip {
+        std::string name;
+        float duration = 0.0f;  // ticks
+        float ticksPerSecond = 25.0f;
+        std::vector<int> channelForBone;
+        std::vector<RawChannel> channels;  // empty for clips loaded already compressed
+
+        // Set by compressClips(); sampling then decodes these instead of the raw channels
+        bool isCompressed = false;
+        CompressedClip compressed;
+
+        // Set by bakePalettes(); instances playing this clip on its own can skip sampling
+        BakedPalettes baked;
+    };
+
+    // Asset with no meshes or textures, from a skeleton and raw clips built in code (procedural
+    // characters, checks). Each clip's channelForBone must have one entry per bone.
+    static std::shared_ptr<CharacterAsset> fromAnimation(Skeleton skeleton, std::vector<CompiledClip> clips);
+
+    // Re-encodes every clip that still has raw keys in the quantized, key-reduced format.
+    // Returns per-clip sizes and errors. jobs, if given, compresses clips in parallel.
+    std::vector<CompressionReport> compressClips(const CompressionSettings& settings, JobSystem* jobs = nullptr);
+
+    // Reorders every mesh's triangles for the post-transform cache and its vertices for fetch
+    // locality (MeshOptimizer). Returns per-mesh ACMR/ATVR before and after. jobs, if given,
+    // optimizes meshes in parallel.
+    std::vector<MeshOptimizationReport> optimizeMeshes(JobSystem* jobs = nullptr);
+
+    // Precomputes the clip's palettes at framesPerSecond for baked playback, shared by every
+    // instance. Bake after compressClips (which discards bakes) so the frames match what
+    // sampling would produce. Reports the memory used and the measured per-update cost.
+    PaletteBakeReport bakePalettes(int clipIndex, float framesPerSecond);
+
+    // Writes the clip's local pose at animationTime (ticks) into out; bones without a channel
+    // (or all bones, if clip is null) take the bind pose. cursors holds one entry per bone.
+    // boneIndices restricts sampling to a subset; the other entries of out are left untouched.
+    void sampleClip(float animationTime, const CompiledClip* clip, KeyCursor* cursors, BoneTransform* out,
+                    const int* boneIndices = nullptr, size_t boneIndexCount = 0) const;
+
+    const Skeleton& getSkeleton() const { return skeleton; }
+    const std::vector<MeshData>& getMeshes() const { return meshes; }
+    const std::vector<CompiledClip>& getClips() const { return clips; }
+
+    const std::vector<EmbeddedTexture>& getEmbeddedTextures() const { return textures; }
+
+    // Get embedded texture data for a "*<index>" texture path, or nullptr
+    const EmbeddedTexture* getEmbeddedTexture(const std::string& path) const;
+
+    const std::vector<BakedTexture>& getBakedTextures() const { return bakedTextures; }
+
+    // Baked texture for a mesh's texturePath, or nullptr if none was baked
+    const BakedTexture* findBakedTexture(const std::string& name) const;
+
+    Metadata getMetadata() const;
+
+    // Approximate heap bytes held by vertex, index, key, palette and texture data, for memory budgets
+    size_t sizeInBytes() const;
+
+private:
+    friend class FBXImporter;
+    friend class CharacterAssetFile;
+    friend class TextureBaker;
+    friend class AssetChunks;
+
+    Skeleton skeleton;
+    std::vector<MeshData> meshes;
+    std::vector<CompiledClip> clips;
+    std::vector<EmbeddedTexture> textures;
+    std::vector<BakedTexture> bakedTextures;
+};
+
+#endif
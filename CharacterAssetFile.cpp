@@ -0,0 +1,575 @@
+#include "CharacterAssetFile.h"
+#include <iostream>
+#include <fstream>
+#include <span>
+#include <map>
+#include <cstring>
+#include <climits>
+#include <type_traits>
+#include "TextureCompression.h"
+
+#if !defined(__EMSCRIPTEN__) && (defined(__unix__) || defined(__APPLE__))
+#define CHARACTER_ASSET_FILE_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using Header = CharacterAssetFile::FileHeader;
+using Section = CharacterAssetFile::SectionEntry;
+using StringRef = CharacterAssetFile::StringRef;
+
+static constexpr uint64_t kSectionAlignment = 16;
+static constexpr uint32_t kNoChannelMap = UINT32_MAX;
+
+static uint64_t alignSection(uint64_t offset) {
+    return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+// Accumulates each section as raw bytes; records are appended in the order they are written
+struct SectionBuilder {
+    struct Payload {
+        uint32_t elementSize = 0;
+        uint64_t count = 0;
+        std::vector<uint8_t> bytes;
+    };
+    std::map<uint32_t, Payload> payloads;
+
+    // Returns the index of the first appended element
+    template <typename T>
+    uint64_t append(CharacterAssetFile::SectionType type, const T* data, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>, "sections hold plain records only");
+        Payload& payload = payloads[type];
+        payload.elementSize = sizeof(T);
+        uint64_t first = payload.count;
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        payload.bytes.insert(payload.bytes.end(), bytes, bytes + count * sizeof(T));
+        payload.count += count;
+        return first;
+    }
+
+    template <typename T>
+    uint64_t append(CharacterAssetFile::SectionType type, const T& record) { return append(type, &record, 1); }
+
+    uint64_t size(CharacterAssetFile::SectionType type) const {
+        auto it = payloads.find(type);
+        return it == payloads.end() ? 0 : it->second.count;
+    }
+
+    StringRef addString(const std::string& text) {
+        StringRef ref = {(uint32_t)append(CharacterAssetFile::Strings, text.data(), text.size()), (uint32_t)text.size()};
+        return ref;
+    }
+
+    bool write(const std::string& path) const {
+        Header header = {};
+        std::memcpy(header.magic, CharacterAssetFile::kMagic, sizeof(header.magic));
+        header.version = CharacterAssetFile::kVersion;
+        header.sectionCount = (uint32_t)payloads.size();
+
+        std::vector<Section> sections;
+        uint64_t offset = alignSection(sizeof(Header) + payloads.size() * sizeof(Section));
+        for (const auto& [type, payload] : payloads) {
+            sections.push_back({type, payload.elementSize, offset, payload.count});
+            offset = alignSection(offset + payload.bytes.size());
+        }
+        header.fileSize = offset;
+
+        std::vector<uint8_t> file(offset, 0);
+        std::memcpy(file.data(), &header, sizeof(header));
+        std::memcpy(file.data() + sizeof(header), sections.data(), sections.size() * sizeof(Section));
+        size_t s = 0;
+        for (const auto& [type, payload] : payloads) {
+            if (!payload.bytes.empty()) std::memcpy(file.data() + sections[s].offset, payload.bytes.data(), payload.bytes.size());
+            s++;
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(file.data()), (std::streamsize)file.size());
+        return (bool)out;
+    }
+};
+
+// Whole file in memory: mapped read-only where the platform allows it, otherwise read in one go
+struct MappedFile {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::vector<uint8_t> buffer;
+#ifdef CHARACTER_ASSET_FILE_MMAP
+    void* mapping = nullptr;
+
+    ~MappedFile() {
+        if (mapping) munmap(mapping, size);
+    }
+#endif
+
+    bool open(const std::string& path) {
+#ifdef CHARACTER_ASSET_FILE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                mapping = mapped;
+                data = static_cast<const uint8_t*>(mapped);
+                size = (size_t)info.st_size;
+            }
+        }
+        ::close(fd);
+        return data != nullptr;
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        buffer.resize((size_t)in.tellg());
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(buffer.data()), (std::streamsize)buffer.size());
+        if (!in) return false;
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+#endif
+    }
+};
+
+// Typed, bounds-checked views of the sections. Any inconsistency clears ok instead of throwing,
+// so a bad file is reported once at the end of load.
+struct SectionReader {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    const Section* sections = nullptr;
+    uint32_t sectionCount = 0;
+    bool ok = true;
+
+    template <typename T>
+    std::span<const T> get(CharacterAssetFile::SectionType type) {
+        for (uint32_t i = 0; i < sectionCount; i++) {
+            const Section& section = sections[i];
+            if (section.type != type) continue;
+            if (section.elementSize != sizeof(T) || section.offset % alignof(T) != 0 ||
+                section.offset > size || section.count > (size - section.offset) / sizeof(T)) {
+                ok = false;
+                return {};
+            }
+            return {reinterpret_cast<const T*>(data + section.offset), (size_t)section.count};
+        }
+        return {};
+    }
+
+    template <typename T>
+    std::span<const T> slice(std::span<const T> all, uint64_t first, uint64_t count) {
+        if (first > all.size() || count > all.size() - first) {
+            ok = false;
+            return {};
+        }
+        return all.subspan((size_t)first, (size_t)count);
+    }
+
+    std::string string(std::span<const char> strings, StringRef ref) {
+        std::span<const char> text = slice(strings, ref.offset, ref.length);
+        return std::string(text.begin(), text.end());
+    }
+};
+
+bool CharacterAssetFile::save(const std::string& path, const CharacterAsset& asset, const BakedAsset& config) {
+    SectionBuilder builder;
+    const Skeleton& skeleton = asset.skeleton;
+    const size_t boneCount = skeleton.size();
+
+    MetaRecord meta = {};
+    meta.globalInverseTransform = skeleton.globalInverseTransform;
+    meta.sourceSkeleton = builder.addString(config.skeleton);
+    meta.lodOffscreenTier = config.lodOffscreenTier;
+    meta.compressionEnabled = config.compression.enabled ? 1 : 0;
+    meta.rotationTolerance = config.compression.rotationTolerance;
+    meta.translationTolerance = config.compression.translationTolerance;
+    meta.scaleTolerance = config.compression.scaleTolerance;
+    builder.append(Meta, meta);
+
+    for (size_t i = 0; i < boneCount; i++) {
+        BoneRecord bone = {};
+        bone.offsetMatrix = skeleton.offsetMatrices[i];
+        bone.rotation = skeleton.bindPose[i].rotation;
+        bone.translation = skeleton.bindPose[i].translation;
+        bone.scale = skeleton.bindPose[i].scale;
+        bone.name = builder.addString(skeleton.names[i]);
+        bone.parentIndex = skeleton.parentIndices[i];
+        builder.append(Bones, bone);
+    }
+
+    for (const auto& mesh : asset.meshes) {
+        MeshRecord record = {};
+        record.firstVertex = builder.append(Vertices, mesh.vertices.data(), mesh.vertices.size());
+        record.vertexCount = mesh.vertices.size();
+        if (mesh.indices.isShort()) {
+            record.firstIndex = builder.append(ShortIndices, mesh.indices.shortIndices.data(), mesh.indices.shortIndices.size());
+        } else {
+            record.firstIndex = builder.append(Indices, mesh.indices.longIndices.data(), mesh.indices.longIndices.size());
+        }
+        record.indexCount = mesh.indices.size();
+        record.indexSize = (uint32_t)mesh.indices.elementSize();
+        record.uvOffset = mesh.uvOffset;
+        record.uvScale = mesh.uvScale;
+        record.texturePath = builder.addString(mesh.texturePath);
+        builder.append(Meshes, record);
+    }
+
+    auto appendTrack = [&builder](const std::vector<uint16_t>& times, const std::vector<uint16_t>& values) {
+        TrackRecord track = {};
+        track.firstTime = (uint32_t)builder.append(CompressedData, times.data(), times.size());
+        track.timeCount = (uint32_t)times.size();
+        track.firstValue = (uint32_t)builder.append(CompressedData, values.data(), values.size());
+        track.valueCount = (uint32_t)values.size();
+        return track;
+    };
+
+    for (const auto& clip : asset.clips) {
+        ClipRecord record = {};
+        record.name = builder.addString(clip.name);
+        record.duration = clip.duration;
+        record.ticksPerSecond = clip.ticksPerSecond;
+        record.rawChannelMap = kNoChannelMap;
+        record.compressedChannelMap = kNoChannelMap;
+
+        // A compressed clip never samples its raw keys again, so they stay out of the file
+        if (!clip.isCompressed && clip.channelForBone.size() == boneCount) {
+            record.rawChannelMap = (uint32_t)builder.append(ChannelMaps, clip.channelForBone.data(), boneCount);
+            record.firstRawChannel = (uint32_t)builder.size(RawChannels);
+            record.rawChannelCount = (uint32_t)clip.channels.size();
+            for (const RawChannel& channel : clip.channels) {
+                RawChannelRecord raw = {};
+                raw.firstPosition = (uint32_t)builder.append(VectorKeys, channel.positions.data(), channel.positions.size());
+                raw.positionCount = (uint32_t)channel.positions.size();
+                raw.firstRotation = (uint32_t)builder.append(RotationKeys, channel.rotations.data(), channel.rotations.size());
+                raw.rotationCount = (uint32_t)channel.rotations.size();
+                raw.firstScaling = (uint32_t)builder.append(VectorKeys, channel.scalings.data(), channel.scalings.size());
+                raw.scalingCount = (uint32_t)channel.scalings.size();
+                builder.append(RawChannels, raw);
+            }
+        }
+
+        if (clip.isCompressed && clip.compressed.channelForBone.size() == boneCount) {
+            const CompressedClip& compressed = clip.compressed;
+            record.isCompressed = 1;
+            record.compressedDuration = compressed.duration;
+            record.compressedChannelMap = (uint32_t)builder.append(ChannelMaps, compressed.channelForBone.data(), boneCount);
+            record.firstCompressedChannel = (uint32_t)builder.size(CompressedChannels);
+            record.compressedChannelCount = (uint32_t)compressed.channels.size();
+            for (const CompressedChannel& channel : compressed.channels) {
+                CompressedChannelRecord channelRecord = {};
+                channelRecord.translation = appendTrack(channel.translation.times, channel.translation.values);
+                channelRecord.translation.rangeMin = channel.translation.rangeMin;
+                channelRecord.translation.rangeExtent = channel.translation.rangeExtent;
+                channelRecord.rotation = appendTrack(channel.rotation.times, channel.rotation.values);
+                channelRecord.scale = appendTrack(channel.scale.times, channel.scale.values);
+                channelRecord.scale.rangeMin = channel.scale.rangeMin;
+                channelRecord.scale.rangeExtent = channel.scale.rangeExtent;
+                builder.append(CompressedChannels, channelRecord);
+            }
+        }
+
+        if (!clip.baked.empty()) {
+            record.bakedFrameCount = (uint32_t)clip.baked.frameCount;
+            record.bakedFrameDuration = clip.baked.frameDuration;
+            record.firstBakedMatrix = builder.append(BakedMatrices, clip.baked.palettes.data(), clip.baked.palettes.size());
+            builder.append(BakedMatrices, clip.baked.worldTransforms.data(), clip.baked.worldTransforms.size());
+        }
+        builder.append(Clips, record);
+    }
+
+    for (const auto& texture : asset.textures) {
+        TextureRecord record = {};
+        record.path = builder.addString(texture.path);
+        record.formatHint = builder.addString(texture.formatHint);
+        record.width = texture.width;
+        record.height = texture.height;
+        record.firstByte = builder.append(TextureData, texture.data.data(), texture.data.size());
+        record.byteCount = texture.data.size();
+        builder.append(Textures, record);
+    }
+
+    for (const auto& texture : asset.bakedTextures) {
+        BakedTextureRecord record = {builder.addString(texture.name), texture.width, texture.height,
+                                     (uint32_t)builder.size(TexturePayloads), (uint32_t)texture.payloads.size()};
+        for (const auto& payload : texture.payloads) {
+            builder.append(TexturePayloads, TexturePayloadRecord{(uint32_t)payload.format, (uint32_t)builder.size(TextureLevels),
+                                                                 (uint32_t)payload.levels.size()});
+            for (const auto& level : payload.levels) {
+                uint64_t firstByte = builder.append(BakedTextureData, level.data.data(), level.data.size());
+                builder.append(TextureLevels, TextureLevelRecord{level.width, level.height, firstByte, level.data.size()});
+            }
+        }
+        builder.append(BakedTextures, record);
+    }
+
+    for (const auto& [name, clip] : config.states) {
+        builder.append(States, StateRecord{builder.addString(name), clip});
+    }
+    for (const auto& collider : config.colliders) {
+        builder.append(Colliders, ColliderRecord{builder.addString(collider.bone), collider.radius, collider.height, collider.damage});
+    }
+    for (const auto& texture : config.textures) {
+        builder.append(TextureNames, builder.addString(texture));
+    }
+    for (const auto& format : config.textureFormats) {
+        builder.append(TextureFormats, builder.addString(format));
+    }
+    for (const auto& tier : config.lodTiers) {
+        LodTierRecord record = {tier.maxDistance, tier.updateInterval, (uint32_t)builder.size(LodSubtrees),
+                                (uint32_t)tier.skippedSubtrees.size()};
+        for (const auto& subtree : tier.skippedSubtrees) builder.append(LodSubtrees, builder.addString(subtree));
+        builder.append(LodTiers, record);
+    }
+    for (const auto& bake : config.paletteBakes) {
+        builder.append(PaletteBakes, PaletteBakeRecord{bake.clip, bake.framesPerSecond});
+    }
+
+    if (!builder.write(path)) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<CharacterAsset> CharacterAssetFile::load(const std::string& path, BakedAsset* config) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Cannot open character file " << path << std::endl;
+        return nullptr;
+    }
+    return load(file.data, file.size, path, config);
+}
+
+std::shared_ptr<CharacterAsset> CharacterAssetFile::load(const uint8_t* data, size_t size, const std::string& path, BakedAsset* config) {
+    Header header;
+    if (size < sizeof(Header)) {
+        std::cerr << path << " is not a character file" << std::endl;
+        return nullptr;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(header.magic)) != 0) {
+        std::cerr << path << " is not a character file" << std::endl;
+        return nullptr;
+    }
+    if (header.version != kVersion) {
+        std::cerr << path << " has version " << header.version << ", expected " << kVersion << "; rebake it" << std::endl;
+        return nullptr;
+    }
+    if (header.fileSize != size || header.sectionCount > (size - sizeof(Header)) / sizeof(Section)) {
+        std::cerr << path << " is truncated" << std::endl;
+        return nullptr;
+    }
+
+    SectionReader reader{data, size, reinterpret_cast<const Section*>(data + sizeof(Header)), header.sectionCount};
+    auto strings = reader.get<char>(Strings);
+    auto metas = reader.get<MetaRecord>(Meta);
+    auto bones = reader.get<BoneRecord>(Bones);
+    auto meshes = reader.get<MeshRecord>(Meshes);
+    auto vertices = reader.get<CharacterAsset::Vertex>(Vertices);
+    auto indices = reader.get<uint32_t>(Indices);
+    auto shortIndices = reader.get<uint16_t>(ShortIndices);
+    auto clips = reader.get<ClipRecord>(Clips);
+    auto channelMaps = reader.get<int32_t>(ChannelMaps);
+    auto rawChannels = reader.get<RawChannelRecord>(RawChannels);
+    auto vectorKeys = reader.get<VectorKey>(VectorKeys);
+    auto rotationKeys = reader.get<RotationKey>(RotationKeys);
+    auto compressedChannels = reader.get<CompressedChannelRecord>(CompressedChannels);
+    auto compressedData = reader.get<uint16_t>(CompressedData);
+    auto bakedMatrices = reader.get<glm::mat4>(BakedMatrices);
+    auto textures = reader.get<TextureRecord>(Textures);
+    auto textureData = reader.get<uint8_t>(TextureData);
+    auto bakedTextures = reader.get<BakedTextureRecord>(BakedTextures);
+    auto texturePayloads = reader.get<TexturePayloadRecord>(TexturePayloads);
+    auto textureLevels = reader.get<TextureLevelRecord>(TextureLevels);
+    auto bakedTextureData = reader.get<uint8_t>(BakedTextureData);
+    if (metas.size() != 1) reader.ok = false;
+
+    auto asset = std::make_shared<CharacterAsset>();
+    Skeleton& skeleton = asset->skeleton;
+    const size_t boneCount = bones.size();
+    for (size_t i = 0; i < boneCount && reader.ok; i++) {
+        const BoneRecord& record = bones[i];
+        if (record.parentIndex < -1 || record.parentIndex >= (int32_t)i) {
+            reader.ok = false;
+            break;
+        }
+        BoneTransform bindLocal;
+        bindLocal.translation = record.translation;
+        bindLocal.rotation = record.rotation;
+        bindLocal.scale = record.scale;
+        skeleton.addBone(reader.string(strings, record.name), record.parentIndex, bindLocal);
+        skeleton.offsetMatrices[i] = record.offsetMatrix;
+    }
+    if (reader.ok) skeleton.globalInverseTransform = metas[0].globalInverseTransform;
+
+    for (const MeshRecord& record : meshes) {
+        CharacterAsset::MeshData mesh;
+        auto meshVertices = reader.slice(vertices, record.firstVertex, record.vertexCount);
+        mesh.vertices.assign(meshVertices.begin(), meshVertices.end());
+        if (record.indexSize == sizeof(uint16_t)) {
+            auto meshIndices = reader.slice(shortIndices, record.firstIndex, record.indexCount);
+            mesh.indices.shortIndices.assign(meshIndices.begin(), meshIndices.end());
+        } else {
+            auto meshIndices = reader.slice(indices, record.firstIndex, record.indexCount);
+            mesh.indices.longIndices.assign(meshIndices.begin(), meshIndices.end());
+        }
+        mesh.uvOffset = record.uvOffset;
+        mesh.uvScale = record.uvScale;
+        mesh.texturePath = reader.string(strings, record.texturePath);
+        asset->meshes.push_back(std::move(mesh));
+    }
+
+    auto channelMap = [&](uint32_t offset) {
+        if (offset == kNoChannelMap) return std::vector<int>(boneCount, -1);
+        auto map = reader.slice(channelMaps, offset, boneCount);
+        return std::vector<int>(map.begin(), map.end());
+    };
+    auto readTrack = [&](const TrackRecord& record, std::vector<uint16_t>& times, std::vector<uint16_t>& values) {
+        if (record.valueCount != record.timeCount * 3) reader.ok = false;
+        auto t = reader.slice(compressedData, record.firstTime, record.timeCount);
+        auto v = reader.slice(compressedData, record.firstValue, record.valueCount);
+        times.assign(t.begin(), t.end());
+        values.assign(v.begin(), v.end());
+    };
+
+    for (const ClipRecord& record : clips) {
+        CharacterAsset::CompiledClip clip;
+        clip.name = reader.string(strings, record.name);
+        clip.duration = record.duration;
+        clip.ticksPerSecond = record.ticksPerSecond;
+        clip.channelForBone = channelMap(record.rawChannelMap);
+        if (record.rawChannelMap != kNoChannelMap) {
+            for (const RawChannelRecord& raw : reader.slice(rawChannels, record.firstRawChannel, record.rawChannelCount)) {
+                RawChannel channel;
+                auto positions = reader.slice(vectorKeys, raw.firstPosition, raw.positionCount);
+                auto rotations = reader.slice(rotationKeys, raw.firstRotation, raw.rotationCount);
+                auto scalings = reader.slice(vectorKeys, raw.firstScaling, raw.scalingCount);
+                channel.positions.assign(positions.begin(), positions.end());
+                channel.rotations.assign(rotations.begin(), rotations.end());
+                channel.scalings.assign(scalings.begin(), scalings.end());
+                clip.channels.push_back(std::move(channel));
+            }
+        }
+
+        if (record.isCompressed) {
+            clip.isCompressed = true;
+            clip.compressed.duration = record.compressedDuration;
+            clip.compressed.channelForBone = channelMap(record.compressedChannelMap);
+            for (const CompressedChannelRecord& channelRecord : reader.slice(compressedChannels, record.firstCompressedChannel, record.compressedChannelCount)) {
+                CompressedChannel channel;
+                readTrack(channelRecord.translation, channel.translation.times, channel.translation.values);
+                channel.translation.rangeMin = channelRecord.translation.rangeMin;
+                channel.translation.rangeExtent = channelRecord.translation.rangeExtent;
+                readTrack(channelRecord.rotation, channel.rotation.times, channel.rotation.values);
+                readTrack(channelRecord.scale, channel.scale.times, channel.scale.values);
+                channel.scale.rangeMin = channelRecord.scale.rangeMin;
+                channel.scale.rangeExtent = channelRecord.scale.rangeExtent;
+                clip.compressed.channels.push_back(std::move(channel));
+            }
+        }
+
+        // Channel indices are only trusted once they are known to be in range
+        for (int channel : clip.channelForBone) {
+            if (channel >= (int)clip.channels.size()) reader.ok = false;
+        }
+        for (int channel : clip.compressed.channelForBone) {
+            if (channel >= (int)clip.compressed.channels.size()) reader.ok = false;
+        }
+
+        if (record.bakedFrameCount > 0) {
+            uint64_t frameMatrices = (uint64_t)record.bakedFrameCount * boneCount;
+            auto palettes = reader.slice(bakedMatrices, record.firstBakedMatrix, frameMatrices);
+            auto world = reader.slice(bakedMatrices, record.firstBakedMatrix + frameMatrices, frameMatrices);
+            clip.baked.frameCount = record.bakedFrameCount;
+            clip.baked.frameDuration = record.bakedFrameDuration;
+            clip.baked.palettes.assign(palettes.begin(), palettes.end());
+            clip.baked.worldTransforms.assign(world.begin(), world.end());
+        }
+        asset->clips.push_back(std::move(clip));
+    }
+
+    for (const TextureRecord& record : textures) {
+        CharacterAsset::EmbeddedTexture texture;
+        texture.path = reader.string(strings, record.path);
+        texture.formatHint = reader.string(strings, record.formatHint);
+        texture.width = record.width;
+        texture.height = record.height;
+        auto bytes = reader.slice(textureData, record.firstByte, record.byteCount);
+        texture.data.assign(bytes.begin(), bytes.end());
+        asset->textures.push_back(std::move(texture));
+    }
+
+    for (const BakedTextureRecord& record : bakedTextures) {
+        CharacterAsset::BakedTexture texture;
+        texture.name = reader.string(strings, record.name);
+        texture.width = record.width;
+        texture.height = record.height;
+        for (const TexturePayloadRecord& payloadRecord : reader.slice(texturePayloads, record.firstPayload, record.payloadCount)) {
+            if (payloadRecord.format > (uint32_t)CharacterAsset::TextureFormat::ETC2_RGBA8) reader.ok = false;
+            CharacterAsset::TexturePayload payload;
+            payload.format = (CharacterAsset::TextureFormat)payloadRecord.format;
+            for (const TextureLevelRecord& levelRecord : reader.slice(textureLevels, payloadRecord.firstLevel, payloadRecord.levelCount)) {
+                if (levelRecord.width <= 0 || levelRecord.height <= 0 ||
+                    levelRecord.byteCount != TextureCompression::levelSize(payload.format, levelRecord.width, levelRecord.height)) {
+                    reader.ok = false;
+                    break;
+                }
+                CharacterAsset::TextureLevel level;
+                level.width = levelRecord.width;
+                level.height = levelRecord.height;
+                auto bytes = reader.slice(bakedTextureData, levelRecord.firstByte, levelRecord.byteCount);
+                level.data.assign(bytes.begin(), bytes.end());
+                payload.levels.push_back(std::move(level));
+            }
+            texture.payloads.push_back(std::move(payload));
+        }
+        asset->bakedTextures.push_back(std::move(texture));
+    }
+
+    if (config) {
+        *config = BakedAsset();
+        if (reader.ok) {
+            const MetaRecord& meta = metas[0];
+            config->skeleton = reader.string(strings, meta.sourceSkeleton);
+            config->lodOffscreenTier = meta.lodOffscreenTier;
+            config->compression.enabled = meta.compressionEnabled != 0;
+            config->compression.rotationTolerance = meta.rotationTolerance;
+            config->compression.translationTolerance = meta.translationTolerance;
+            config->compression.scaleTolerance = meta.scaleTolerance;
+        }
+        for (const StateRecord& record : reader.get<StateRecord>(States)) {
+            config->states[reader.string(strings, record.name)] = record.clip;
+        }
+        for (const ColliderRecord& record : reader.get<ColliderRecord>(Colliders)) {
+            config->colliders.push_back({reader.string(strings, record.bone), record.radius, record.height, record.damage});
+        }
+        for (const StringRef& name : reader.get<StringRef>(TextureNames)) {
+            config->textures.push_back(reader.string(strings, name));
+        }
+        auto formats = reader.get<StringRef>(TextureFormats);
+        if (!formats.empty()) config->textureFormats.clear();
+        for (const StringRef& name : formats) {
+            config->textureFormats.push_back(reader.string(strings, name));
+        }
+        auto subtrees = reader.get<StringRef>(LodSubtrees);
+        for (const LodTierRecord& record : reader.get<LodTierRecord>(LodTiers)) {
+            AnimationLODTier tier;
+            tier.maxDistance = record.maxDistance;
+            tier.updateInterval = record.updateInterval;
+            for (const StringRef& name : reader.slice(subtrees, record.firstSubtree, record.subtreeCount)) {
+                tier.skippedSubtrees.push_back(reader.string(strings, name));
+            }
+            config->lodTiers.push_back(tier);
+        }
+        for (const PaletteBakeRecord& record : reader.get<PaletteBakeRecord>(PaletteBakes)) {
+            config->paletteBakes.push_back({record.clip, record.framesPerSecond});
+        }
+    }
+
+    if (!reader.ok) {
+        std::cerr << path << " is corrupt" << std::endl;
+        return nullptr;
+    }
+    return asset;
+}
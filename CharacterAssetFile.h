@@ -0,0 +1,205 @@
+#ifndef CHARACTER_ASSET_FILE_H
+#define CHARACTER_ASSET_FILE_H
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "CharacterAsset.h"
+#include "AssetBaking.h"
+
+// Versioned binary container for a baked character: skeleton, vertex/index buffers, clips (raw or
+// compressed, plus baked palettes), embedded and baked textures and the BakedAsset config (state mapping,
+// colliders, LOD tiers). Every section is a flat array of fixed-size records at a 16-byte aligned
+// offset, so loading is mapping the file and copying arrays out; there is nothing to parse and
+// no Assimp at runtime.
+//
+// Layout: FileHeader, then sectionCount SectionEntry records, then the section payloads.
+class CharacterAssetFile {
+public:
+    static constexpr char kMagic[8] = {'C', 'H', 'A', 'R', 'B', 'I', 'N', '\0'};
+    static constexpr uint32_t kVersion = 3;
+
+    enum SectionType : uint32_t {
+        Strings = 1,        // char blob, referenced by StringRef
+        Meta,               // one MetaRecord
+        Bones,              // BoneRecord, in skeleton order
+        Meshes,             // MeshRecord
+        Vertices,           // CharacterAsset::Vertex
+        Indices,            // uint32_t, meshes too large for ShortIndices
+        Clips,              // ClipRecord
+        ChannelMaps,        // int32_t, boneCount per map
+        RawChannels,        // RawChannelRecord
+        VectorKeys,         // VectorKey
+        RotationKeys,       // RotationKey
+        CompressedChannels, // CompressedChannelRecord
+        CompressedData,     // uint16_t, times and values of every compressed track
+        BakedMatrices,      // glm::mat4
+        Textures,           // TextureRecord
+        TextureData,        // uint8_t
+        States,             // StateRecord
+        Colliders,          // ColliderRecord
+        TextureNames,       // StringRef
+        LodTiers,           // LodTierRecord
+        LodSubtrees,        // StringRef
+        PaletteBakes,       // PaletteBakeRecord
+        ShortIndices,       // uint16_t
+        BakedTextures,      // BakedTextureRecord
+        TexturePayloads,    // TexturePayloadRecord
+        TextureLevels,      // TextureLevelRecord
+        BakedTextureData,   // uint8_t, every level of every payload
+        TextureFormats      // StringRef
+    };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t sectionCount;
+        uint64_t fileSize;
+    };
+
+    struct SectionEntry {
+        uint32_t type;
+        uint32_t elementSize;  // checked against the reader's record size
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct StringRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct MetaRecord {
+        glm::mat4 globalInverseTransform;
+        StringRef sourceSkeleton;
+        int32_t lodOffscreenTier;
+        uint32_t compressionEnabled;
+        float rotationTolerance;
+        float translationTolerance;
+        float scaleTolerance;
+    };
+
+    struct BoneRecord {
+        glm::mat4 offsetMatrix;
+        glm::quat rotation;
+        glm::vec3 translation;
+        glm::vec3 scale;
+        StringRef name;
+        int32_t parentIndex;
+    };
+
+    struct MeshRecord {
+        uint64_t firstVertex;
+        uint64_t vertexCount;
+        uint64_t firstIndex;  // into ShortIndices or Indices, by indexSize
+        uint64_t indexCount;
+        glm::vec2 uvOffset;
+        glm::vec2 uvScale;
+        StringRef texturePath;
+        uint32_t indexSize;
+    };
+
+    struct ClipRecord {
+        StringRef name;
+        float duration;  // ticks
+        float ticksPerSecond;
+        uint32_t rawChannelMap;  // offset into ChannelMaps, or UINT32_MAX without raw keys
+        uint32_t firstRawChannel;
+        uint32_t rawChannelCount;
+        uint32_t isCompressed;
+        float compressedDuration;
+        uint32_t compressedChannelMap;
+        uint32_t firstCompressedChannel;
+        uint32_t compressedChannelCount;
+        uint32_t bakedFrameCount;  // palettes then world transforms, frameCount * boneCount each
+        float bakedFrameDuration;
+        uint64_t firstBakedMatrix;
+    };
+
+    struct RawChannelRecord {
+        uint32_t firstPosition, positionCount;
+        uint32_t firstRotation, rotationCount;
+        uint32_t firstScaling, scalingCount;
+    };
+
+    struct TrackRecord {
+        glm::vec3 rangeMin;
+        glm::vec3 rangeExtent;
+        uint32_t firstTime, timeCount;  // into CompressedData
+        uint32_t firstValue, valueCount;
+    };
+
+    struct CompressedChannelRecord {
+        TrackRecord translation;
+        TrackRecord rotation;
+        TrackRecord scale;
+    };
+
+    struct TextureRecord {
+        StringRef path;
+        StringRef formatHint;
+        int32_t width;
+        int32_t height;
+        uint64_t firstByte;
+        uint64_t byteCount;
+    };
+
+    struct BakedTextureRecord {
+        StringRef name;
+        int32_t width;
+        int32_t height;
+        uint32_t firstPayload;
+        uint32_t payloadCount;
+    };
+
+    struct TexturePayloadRecord {
+        uint32_t format;  // CharacterAsset::TextureFormat
+        uint32_t firstLevel;
+        uint32_t levelCount;
+    };
+
+    struct TextureLevelRecord {
+        int32_t width;
+        int32_t height;
+        uint64_t firstByte;
+        uint64_t byteCount;
+    };
+
+    struct StateRecord {
+        StringRef name;
+        int32_t clip;
+    };
+
+    struct ColliderRecord {
+        StringRef bone;
+        float radius;
+        float height;
+        float damage;
+    };
+
+    struct LodTierRecord {
+        float maxDistance;
+        int32_t updateInterval;
+        uint32_t firstSubtree;
+        uint32_t subtreeCount;
+    };
+
+    struct PaletteBakeRecord {
+        int32_t clip;
+        float framesPerSecond;
+    };
+
+    // Writes the asset as it is now (compress and bake first) together with its config
+    static bool save(const std::string& path, const CharacterAsset& asset, const BakedAsset& config);
+
+    // Returns nullptr if the file is missing, truncated or from another version. config, if
+    // given, receives the state mapping, colliders and the rest of the stored BakedAsset.
+    static std::shared_ptr<CharacterAsset> load(const std::string& path, BakedAsset* config = nullptr);
+
+    // Same, from a file already in memory (a streamed chunk). data must be 8-byte aligned, as
+    // malloc'd buffers are; path only labels errors.
+    static std::shared_ptr<CharacterAsset> load(const uint8_t* data, size_t size, const std::string& path,
+                                                BakedAsset* config = nullptr);
+};
+
+#endif
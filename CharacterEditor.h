@@ -10,12 +10,17 @@
 #include <cstddef>
 #include <algorithm>
 #include <cctype>
+#include <memory>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <GL/glew.h>
-#include "stb_image.h"
 #include "FBXStateMachine.h"
 #include "AssetBaking.h"
+#include "FBXImporter.h"
+#include "ImportCache.h"
+#include "CharacterAssetFile.h"
+#include "TextureBaker.h"
+#include "TextureUpload.h"
 
 class CharacterEditor {
 public:
@@ -54,23 +59,24 @@ public:
         const char* svSrc = R"(#version 330 core
             layout(location = 0) in vec3 aPos;
             layout(location = 1) in vec2 aUV;
-            layout(location = 2) in ivec4 aBoneIds;
+            layout(location = 2) in uvec4 aBoneIds;
             layout(location = 3) in vec4 aWeights;
             uniform mat4 uVP;
+            uniform vec4 uUVTransform;
             uniform mat4 uBones[256];
             out vec2 vUV;
             void main() {
                 vec4 pos = vec4(0.0);
                 float totalWeight = 0.0;
                 for(int i=0; i<4; i++) {
-                    if(aBoneIds[i] >= 0 && aBoneIds[i] < 256) {
+                    if(aBoneIds[i] < 256u) {
                         pos += aWeights[i] * (uBones[aBoneIds[i]] * vec4(aPos, 1.0));
                         totalWeight += aWeights[i];
                     }
                 }
                 if (totalWeight < 0.01) pos = vec4(aPos, 1.0);
                 gl_Position = uVP * vec4(pos.xyz, 1.0);
-                vUV = aUV;
+                vUV = uUVTransform.xy + uUVTransform.zw * aUV;
             }
         )";
         glShaderSource(vShader, 1, &svSrc, nullptr);
@@ -116,17 +122,30 @@ public:
 
         currentAsset.textures.clear();
         const auto& meshes = sm.getMeshes();
+
+        // Textures were decoded and mipped with the import (or come from the import cache), so
+        // this is only the upload
+        std::vector<std::string> texturePaths;
+        for (const auto& mData : meshes) {
+            const std::string& path = mData.texturePath;
+            if (!path.empty() && std::find(texturePaths.begin(), texturePaths.end(), path) == texturePaths.end()) {
+                texturePaths.push_back(path);
+            }
+        }
+        for (const std::string& path : texturePaths) {
+            const CharacterAsset::BakedTexture* preview = characterAsset ? characterAsset->findBakedTexture(path) : nullptr;
+            if (!preview) continue;
+            GLuint texID = TextureUpload::upload(*preview, TextureUpload::Support());
+            if (texID != 0) {
+                textureCache[path] = texID;
+                currentAsset.textures.push_back(path);
+            }
+        }
+
         for (const auto& mData : meshes) {
             MeshGL m;
             m.textureID = 0;
             if (!mData.texturePath.empty()) {
-                if (textureCache.find(mData.texturePath) == textureCache.end()) {
-                    GLuint texID = loadTexture(mData.texturePath);
-                    if (texID != 0) {
-                        textureCache[mData.texturePath] = texID;
-                        currentAsset.textures.push_back(mData.texturePath);
-                    }
-                }
                 if (textureCache.count(mData.texturePath)) {
                     m.textureID = textureCache[mData.texturePath];
                 }
@@ -141,18 +160,20 @@ public:
             glBufferData(GL_ARRAY_BUFFER, mData.vertices.size() * sizeof(FBXStateMachine::Vertex), mData.vertices.data(), GL_STATIC_DRAW);
 
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.ebo);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mData.indices.size() * sizeof(unsigned int), mData.indices.data(), GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mData.indices.size() * mData.indices.elementSize(), mData.indices.data(), GL_STATIC_DRAW);
 
             glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, position));
             glEnableVertexAttribArray(0);
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, uv));
+            glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, uv));
             glEnableVertexAttribArray(1);
-            glVertexAttribIPointer(2, 4, GL_INT, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, boneIds));
+            glVertexAttribIPointer(2, 4, GL_UNSIGNED_BYTE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, boneIds));
             glEnableVertexAttribArray(2);
-            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, weights));
+            glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, weights));
             glEnableVertexAttribArray(3);
 
             m.count = (GLsizei)mData.indices.size();
+            m.indexType = mData.indices.isShort() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            m.uvTransform = glm::vec4(mData.uvOffset, mData.uvScale);
             meshGLs.push_back(m);
         }
         glBindVertexArray(0);
@@ -178,7 +199,7 @@ public:
             glUseProgram(skinnedShader);
             glUniformMatrix4fv(glGetUniformLocation(skinnedShader, "uVP"), 1, GL_FALSE, glm::value_ptr(vp));
             
-            auto finalMatrices = sm.getFinalBoneMatrices();
+            std::span<const glm::mat4> finalMatrices = sm.getFinalBoneMatrices();
             if (!finalMatrices.empty()) {
                 glUniformMatrix4fv(glGetUniformLocation(skinnedShader, "uBones"), (GLsizei)finalMatrices.size(), GL_FALSE, glm::value_ptr(finalMatrices[0]));
             }
@@ -192,8 +213,9 @@ public:
                 } else {
                     glUniform1i(glGetUniformLocation(skinnedShader, "uHasTexture"), 0);
                 }
+                glUniform4fv(glGetUniformLocation(skinnedShader, "uUVTransform"), 1, glm::value_ptr(m.uvTransform));
                 glBindVertexArray(m.vao);
-                glDrawElements(GL_TRIANGLES, m.count, GL_UNSIGNED_INT, 0);
+                glDrawElements(GL_TRIANGLES, m.count, m.indexType, 0);
             }
             glBindVertexArray(0);
         }
@@ -254,9 +276,12 @@ public:
         static char fbxPath[256] = "soldier.fbx";
         ImGui::InputText("FBX Path", fbxPath, 256);
         if (ImGui::Button("Load FBX")) {
-            currentAsset.skeleton = fbxPath;
-            sm.loadFBX(fbxPath);
-            setupMeshGL();
+            loadFBX(fbxPath, false);
+        }
+        ImGui::SameLine();
+        // Bypasses the cache lookup, e.g. after adding a texture that was missing
+        if (ImGui::Button("Reimport")) {
+            loadFBX(fbxPath, true);
         }
 
         auto meta = sm.getMetadata();
@@ -265,6 +290,22 @@ public:
             ImGui::BulletText("Meshes: %d", meta.numMeshes);
             ImGui::BulletText("Animations: %d", meta.numAnimations);
             ImGui::BulletText("Bones: %d", meta.numBones);
+            if (ImGui::TreeNode("Import Timings")) {
+                ImGui::Text("%s: %s", importReport.hit ? "Cache hit" : "Imported", importReport.entryPath.c_str());
+                ImGui::Text("Hash: %.1f ms", importReport.hashMs);
+                if (importReport.hit) {
+                    ImGui::Text("Cache read: %.1f ms", importReport.cacheReadMs);
+                } else {
+                    const ImportTimings& timings = importReport.import;
+                    ImGui::Text("Read: %.1f ms", timings.readMs);
+                    ImGui::Text("Skeleton: %.1f ms", timings.skeletonMs);
+                    ImGui::Text("Extraction: %.1f ms (meshes %.1f, clips %.1f, textures %.1f, summed)",
+                                timings.extractMs, timings.meshesMs, timings.clipsMs, timings.texturesMs);
+                    ImGui::Text("Texture decode: %.1f ms", importReport.texturesMs);
+                    ImGui::Text("Cache write: %.1f ms", importReport.storeMs);
+                }
+                ImGui::TreePop();
+            }
             if (ImGui::TreeNode("Animation Names")) {
                 for (const auto& name : meta.animationNames) {
                     ImGui::Text("- %s", name.c_str());
@@ -331,10 +372,77 @@ public:
             }
         }
 
+        ImGui::Separator();
+        ImGui::Text("Clip Compression");
+        ImGui::Checkbox("Compress Clips On Load", &currentAsset.compression.enabled);
+        ImGui::DragFloat("Rotation Tolerance (rad)", &currentAsset.compression.rotationTolerance, 0.0001f, 0.0f, 0.1f, "%.4f");
+        ImGui::DragFloat("Translation Tolerance", &currentAsset.compression.translationTolerance, 0.001f, 0.0f, 10.0f, "%.3f");
+        ImGui::DragFloat("Scale Tolerance", &currentAsset.compression.scaleTolerance, 0.0001f, 0.0f, 1.0f, "%.4f");
+        if (ImGui::Button("Compress Clips") && characterAsset) {
+            compressionReports = characterAsset->compressClips(currentAsset.compression, &importJobs);
+            bakeReports.clear();
+            sm.setAsset(characterAsset);
+        }
+        for (const auto& report : compressionReports) {
+            ImGui::BulletText("%s: %zu -> %zu bytes (%.1f%%), max err rot %.5f pos %.4f scale %.5f",
+                              report.clipName.c_str(), report.rawBytes, report.compressedBytes,
+                              report.rawBytes ? 100.0f * report.compressedBytes / report.rawBytes : 0.0f,
+                              report.maxRotationError, report.maxTranslationError, report.maxScaleError);
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Baked Palettes");
+        static int bakeClip = 0;
+        static float bakeRate = 30.0f;
+        ImGui::InputInt("Bake Clip", &bakeClip);
+        ImGui::DragFloat("Frames Per Second", &bakeRate, 1.0f, 1.0f, 120.0f);
+        if (ImGui::Button("Bake Clip Palettes") && characterAsset) {
+            PaletteBakeReport report = characterAsset->bakePalettes(bakeClip, bakeRate);
+            if (report.frameCount > 0) {
+                bakeReports.push_back(report);
+                currentAsset.paletteBakes.push_back({bakeClip, bakeRate});
+            }
+        }
+        for (const auto& report : bakeReports) {
+            ImGui::BulletText("%s: %zu frames, %.1f KB shared, %.0f -> %.0f ns per instance update",
+                              report.clipName.c_str(), report.frameCount, report.bytes / 1024.0f,
+                              report.sampledNsPerUpdate, report.bakedNsPerUpdate);
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Animation Layers");
+        static int layerClip = 0;
+        static char maskRoot[64] = "spine_01";
+        static bool layerAdditive = false;
+        ImGui::InputInt("Layer Clip", &layerClip);
+        ImGui::InputText("Mask Root Bone", maskRoot, 64);
+        ImGui::Checkbox("Additive", &layerAdditive);
+        if (ImGui::Button("Add Layer")) {
+            BoneMask mask;
+            if (mask.setSubtree(sm.getSkeleton(), maskRoot, 1.0f)) {
+                sm.getLayers().addLayer(layerClip, layerAdditive ? LayerBlendMode::Additive : LayerBlendMode::Override, &mask);
+            } else {
+                std::cerr << "Mask root bone not found: " << maskRoot << std::endl;
+            }
+        }
+        for (size_t i = 0; i < sm.getLayers().size(); i++) {
+            const auto& layer = sm.getLayers().getLayer((int)i);
+            float weight = layer.weight;
+            std::string label = "Layer " + std::to_string(i) + " (clip " + std::to_string(layer.clipIndex) +
+                                (layer.mode == LayerBlendMode::Additive ? ", additive, " : ", ") +
+                                std::to_string(layer.mask.bones.size()) + " bones)";
+            if (ImGui::SliderFloat(label.c_str(), &weight, 0.0f, 1.0f)) sm.getLayers().setWeight((int)i, weight);
+        }
+
         ImGui::Separator();
         if (ImGui::Button("Save Baked Asset")) {
             AssetBaking::save("soldier.asset.json", currentAsset);
         }
+        // Runtime format: the asset as it is now, with its current compression and palette bakes
+        if (characterAsset && ImGui::Button("Export Binary")) {
+            TextureBaker::bakeTextures(*characterAsset, currentAsset.skeleton, {}, currentAsset.textureFormats, &importJobs);
+            CharacterAssetFile::save("soldier.character", *characterAsset, currentAsset);
+        }
 
         ImGui::End();
     }
@@ -357,6 +465,7 @@ private:
         }
     }
 
+    std::shared_ptr<CharacterAsset> characterAsset;
     FBXStateMachine sm;
     BakedAsset currentAsset;
     GLuint lineShader, lineVAO, lineVBO;
@@ -364,106 +473,28 @@ private:
     struct MeshGL {
         GLuint vao, vbo, ebo;
         GLsizei count;
+        GLenum indexType = GL_UNSIGNED_INT;
+        glm::vec4 uvTransform = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);  // offset, scale
         GLuint textureID = 0;
     };
 
-    GLuint loadTexture(const std::string& path) {
-        if (path.empty()) return 0;
-        
-        unsigned char *data = nullptr;
-        int width, height, nrChannels;
-        stbi_set_flip_vertically_on_load(true);
-
-        std::vector<std::string> pathsToTry;
-        if (path[0] == '*') {
-            const aiTexture* embedded = sm.getEmbeddedTexture(path);
-            if (embedded) {
-                if (embedded->mHeight == 0) {
-                    data = stbi_load_from_memory((unsigned char*)embedded->pcData, embedded->mWidth, &width, &height, &nrChannels, 0);
-                } else {
-                    // Raw ARGB8888 data
-                    data = (unsigned char*)malloc(embedded->mWidth * embedded->mHeight * 4);
-                    memcpy(data, embedded->pcData, embedded->mWidth * embedded->mHeight * 4);
-                    width = embedded->mWidth;
-                    height = embedded->mHeight;
-                    nrChannels = 4;
-                }
-            }
-        } else {
-            std::string filename = path;
-            std::string dir = "";
-            size_t lastSlash = path.find_last_of("/\\");
-            if (lastSlash != std::string::npos) {
-                dir = path.substr(0, lastSlash + 1);
-                filename = path.substr(lastSlash + 1);
-            }
-
-            pathsToTry.push_back(path);
-            pathsToTry.push_back(dir + "textures/" + filename);
-            pathsToTry.push_back(dir + "Textures/" + filename);
-
-            std::string fbxBase = currentAsset.skeleton;
-            size_t lastFbxSlash = fbxBase.find_last_of("/\\");
-            if (lastFbxSlash != std::string::npos) fbxBase = fbxBase.substr(lastFbxSlash + 1);
-            size_t lastFbxDot = fbxBase.find_last_of('.');
-            if (lastFbxDot != std::string::npos) fbxBase = fbxBase.substr(0, lastFbxDot);
-            
-            if (!fbxBase.empty()) {
-                pathsToTry.push_back(dir + fbxBase + ".fbm/" + filename);
-            }
-
-            size_t lastDot = filename.find_last_of('.');
-            if (lastDot != std::string::npos) {
-                std::string base = filename.substr(0, lastDot);
-                std::string ext = filename.substr(lastDot);
-                for (auto& c : ext) c = (char)std::tolower((unsigned char)c);
-                
-                std::vector<std::string> altExts = {".png", ".jpg", ".jpeg", ".tga", ".bmp"};
-                for (const auto& alt : altExts) {
-                    if (alt != ext) {
-                        pathsToTry.push_back(dir + base + alt);
-                        pathsToTry.push_back(dir + "textures/" + base + alt);
-                        if (!fbxBase.empty()) {
-                            pathsToTry.push_back(dir + fbxBase + ".fbm/" + base + alt);
-                        }
-                    }
-                }
-            }
-
-            if (!dir.empty()) {
-                pathsToTry.push_back(filename);
-            }
-
-            for (const auto& tryPath : pathsToTry) {
-                data = stbi_load(tryPath.c_str(), &width, &height, &nrChannels, 0);
-                if (data) break;
-            }
-        }
-
-        if (data) {
-            GLuint textureID;
-            glGenTextures(1, &textureID);
-            glBindTexture(GL_TEXTURE_2D, textureID);
-            GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            stbi_image_free(data);
-            return textureID;
-        } else {
-            std::cerr << "Texture failed to load: " << path << std::endl;
-            if (!pathsToTry.empty()) {
-                std::cerr << "Tried paths:" << std::endl;
-                for (const auto& t : pathsToTry) std::cerr << "  " << t << std::endl;
-            }
-            return 0;
-        }
+    void loadFBX(const std::string& path, bool reimport) {
+        currentAsset.skeleton = path;
+        characterAsset = importCache.load(path, &importJobs, &importReport, reimport);
+        sm.setAsset(characterAsset);
+        compressionReports.clear();
+        bakeReports.clear();
+        setupMeshGL();
     }
+
+    // Imports keep uncompressed previews of their textures; "Export Binary" bakes the real formats
+    ImportCache importCache{".import_cache", {"rgba8"}};
+    JobSystem importJobs;
+    ImportCacheReport importReport;
     std::vector<MeshGL> meshGLs;
     std::map<std::string, GLuint> textureCache;
+    std::vector<CompressionReport> compressionReports;
+    std::vector<PaletteBakeReport> bakeReports;
     bool showSkinnedMesh = false;
     bool showBoneLabels = false;
     float cameraDist = 300.0f;
@@ -3,100 +3,163 @@
 
 #include <vector>
 #include <string>
+#include <iostream>
+#include <limits>
 #include <glm/glm.hpp>
 #include "FBXStateMachine.h"
+#include "JobSystem.h"
+#include "CapsuleRaycast.h"
 
+// Collider as configured; setupColliders binds boneName to a bone index once
 struct Capsule {
     std::string boneName;
     float radius;
     float height;
     float damageMultiplier;
-    glm::vec3 start; // world space
-    glm::vec3 end;   // world space
 };
 
 struct HitResult {
-    std::string boneName;
-    glm::vec3 position;
-    glm::vec3 normal;
-    float damage;
+    int boneIndex = -1;  // skeleton bone; CharacterPhysics::boneName resolves it
+    int collider = -1;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 normal = glm::vec3(0.0f);
+    float distance = 0.0f;  // ray parameter, the distance along a normalized direction
+    float damage = 0.0f;
 };
 
 class CharacterPhysics {
 public:
-    void setupColliders(const std::vector<Capsule>& config) {
-        colliders = config;
-    }
-
-    void update(const std::vector<Bone>& bones, const glm::mat4& modelTransform) {
-        for (auto& cap : colliders) {
-            // Find bone transform
-            for (const auto& bone : bones) {
-                if (bone.name == cap.boneName) {
-                    glm::mat4 boneWorld = modelTransform * bone.finalTransform;
-                    // For simplicity, capsule centers follow bone
-                    cap.start = glm::vec3(boneWorld * glm::vec4(0, 0, 0, 1));
-                    cap.end = glm::vec3(boneWorld * glm::vec4(0, cap.height, 0, 1));
+    // Colliders on bones the skeleton doesn't have are dropped with a warning
+    void setupColliders(const std::vector<Capsule>& config, const Skeleton& skeleton) {
+        colliders = Colliders();
+        for (const auto& cap : config) {
+            int bone = -1;
+            for (size_t i = 0; i < skeleton.names.size(); i++) {
+                if (skeleton.names[i] == cap.boneName) {
+                    bone = (int)i;
                     break;
                 }
             }
+            if (bone < 0) {
+                std::cerr << "Collider bone '" << cap.boneName << "' not found in the skeleton" << std::endl;
+                continue;
+            }
+            colliders.bones.push_back(bone);
+            colliders.radius.push_back(cap.radius);
+            colliders.height.push_back(cap.height);
+            colliders.damage.push_back(cap.damageMultiplier);
+        }
+        size_t count = colliders.bones.size();
+        for (auto* axis : {&colliders.startX, &colliders.startY, &colliders.startZ, &colliders.endX, &colliders.endY, &colliders.endZ}) {
+            axis->assign(count, 0.0f);
         }
     }
 
-    bool raycast(glm::vec3 rayOrigin, glm::vec3 rayDir, float maxDist, HitResult& hit) {
-        float minDist = maxDist;
-        bool found = false;
-
-        for (const auto& cap : colliders) {
-            float t;
-            if (rayCapsuleIntersection(rayOrigin, rayDir, cap.start, cap.end, cap.radius, t)) {
-                if (t < minDist) {
-                    minDist = t;
-                    hit.boneName = cap.boneName;
-                    hit.position = rayOrigin + rayDir * t;
-                    hit.normal = glm::normalize(hit.position - (cap.start + cap.end) * 0.5f); // Rough normal
-                    hit.damage = cap.damageMultiplier;
-                    found = true;
-                }
-            }
+    void update(const BoneList& bones, const glm::mat4& modelTransform) {
+        update(bones.getPalette(), bones.size(), modelTransform);
+    }
+
+    // Capsules follow their bone's skinning matrix: start at its origin, end height along its Y
+    void update(const glm::mat4* palette, size_t boneCount, const glm::mat4& modelTransform) {
+        const size_t count = colliders.bones.size();
+        for (size_t i = 0; i < count; i++) {
+            size_t bone = (size_t)colliders.bones[i];
+            if (bone >= boneCount) continue;
+            const glm::mat4& boneTransform = palette[bone];
+            glm::vec4 start = modelTransform * boneTransform[3];
+            glm::vec4 end = modelTransform * (boneTransform[3] + colliders.height[i] * boneTransform[1]);
+            colliders.startX[i] = start.x;
+            colliders.startY[i] = start.y;
+            colliders.startZ[i] = start.z;
+            colliders.endX[i] = end.x;
+            colliders.endY[i] = end.y;
+            colliders.endZ[i] = end.z;
         }
-        return found;
     }
 
-private:
-    bool rayCapsuleIntersection(glm::vec3 ro, glm::vec3 rd, glm::vec3 a, glm::vec3 b, float r, float& t) {
-        // Implementation of Ray-Capsule intersection
-        // For simplicity, treat as sphere for now or implement full check
-        glm::vec3 ba = b - a;
-        glm::vec3 oa = ro - a;
-        float baba = glm::dot(ba, ba);
-        float bard = glm::dot(ba, rd);
-        float baoa = glm::dot(ba, oa);
-        float rdoa = glm::dot(rd, oa);
-        float oaoa = glm::dot(oa, oa);
-
-        float a_coeff = baba - bard * bard;
-        float b_coeff = baba * rdoa - baoa * bard;
-        float c_coeff = baba * oaoa - baoa * baoa - r * r * baba;
-        float h = b_coeff * b_coeff - a_coeff * c_coeff;
-        if (h >= 0.0f) {
-            t = (-b_coeff - sqrt(h)) / a_coeff;
-            float y = baoa + t * bard;
-            if (y > 0.0 && y < baba) return true;
-            // Cap intersections
-            glm::vec3 oc = (y <= 0.0) ? oa : ro - b;
-            b_coeff = glm::dot(rd, oc);
-            c_coeff = glm::dot(oc, oc) - r * r;
-            h = b_coeff * b_coeff - c_coeff;
-            if (h >= 0.0) {
-                t = -b_coeff - sqrt(h);
-                return true;
+    bool raycast(glm::vec3 rayOrigin, glm::vec3 rayDir, float maxDist, HitResult& hit) const {
+        return raycast({rayOrigin, rayDir, maxDist}, hit);
+    }
+
+    bool raycast(const Ray& ray, HitResult& hit) const {
+        float t;
+        int collider = CapsuleRaycast::nearest(ray, capsules(), t);
+        if (collider < 0) return false;
+        fillHit(ray, collider, t, hit);
+        return true;
+    }
+
+    // Nearest hit of every ray; hits[i].collider is -1 for a miss. Returns how many rays hit.
+    // jobs, if given, splits the rays over its threads.
+    size_t raycastBatch(const Ray* rays, size_t count, HitResult* hits, JobSystem* jobs = nullptr) const {
+        auto run = [&](size_t begin, size_t end) {
+            CapsuleSoA soa = capsules();
+            for (size_t i = begin; i < end; i++) {
+                float t;
+                int collider = CapsuleRaycast::nearest(rays[i], soa, t);
+                if (collider >= 0) fillHit(rays[i], collider, t, hits[i]);
+                else hits[i] = HitResult();
             }
+        };
+        if (jobs) jobs->parallelFor(count, 64, run);
+        else run(0, count);
+
+        size_t hitCount = 0;
+        for (size_t i = 0; i < count; i++) hitCount += hits[i].collider >= 0;
+        return hitCount;
+    }
+
+    size_t colliderCount() const { return colliders.bones.size(); }
+
+    // World-space box around every capsule as of the last update(); false without colliders
+    bool bounds(glm::vec3& low, glm::vec3& high) const {
+        const size_t count = colliders.bones.size();
+        if (count == 0) return false;
+        low = glm::vec3(std::numeric_limits<float>::max());
+        high = glm::vec3(-std::numeric_limits<float>::max());
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3 r(colliders.radius[i]);
+            low = glm::min(low, glm::min(start(i), end(i)) - r);
+            high = glm::max(high, glm::max(start(i), end(i)) + r);
         }
-        return false;
+        return true;
+    }
+
+    // Name of the bone a hit landed on, for logs and gameplay code that wants it
+    static const std::string& boneName(const Skeleton& skeleton, const HitResult& hit) {
+        static const std::string none;
+        return hit.boneIndex >= 0 && (size_t)hit.boneIndex < skeleton.names.size() ? skeleton.names[hit.boneIndex] : none;
+    }
+
+private:
+    // Structure of arrays, one entry per collider; the world-space endpoints are rewritten by update()
+    struct Colliders {
+        std::vector<int> bones;
+        std::vector<float> radius;
+        std::vector<float> height;
+        std::vector<float> damage;
+        std::vector<float> startX, startY, startZ;
+        std::vector<float> endX, endY, endZ;
+    };
+
+    glm::vec3 start(size_t i) const { return glm::vec3(colliders.startX[i], colliders.startY[i], colliders.startZ[i]); }
+    glm::vec3 end(size_t i) const { return glm::vec3(colliders.endX[i], colliders.endY[i], colliders.endZ[i]); }
+
+    CapsuleSoA capsules() const {
+        return {colliders.startX.data(), colliders.startY.data(), colliders.startZ.data(), colliders.endX.data(),
+                colliders.endY.data(), colliders.endZ.data(), colliders.radius.data(), colliders.bones.size()};
+    }
+
+    void fillHit(const Ray& ray, int collider, float t, HitResult& hit) const {
+        hit.boneIndex = colliders.bones[collider];
+        hit.collider = collider;
+        hit.distance = t;
+        hit.position = ray.origin + ray.direction * t;
+        hit.normal = glm::normalize(hit.position - (start(collider) + end(collider)) * 0.5f); // Rough normal
+        hit.damage = colliders.damage[collider];
     }
 
-    std::vector<Capsule> colliders;
+    Colliders colliders;
 };
 
 #endif
@@ -0,0 +1,61 @@
+#ifndef CHARACTER_SETUP_H
+#define CHARACTER_SETUP_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include "AssetBaking.h"
+#include "CharacterAsset.h"
+#include "FBXStateMachine.h"
+#include "CharacterPhysics.h"
+
+// Turns a baked asset description into runtime objects; shared by the player and the server.
+class CharacterSetup {
+public:
+    // Applies the asset's mesh optimization, clip compression and palette bakes to a freshly
+    // imported character, logging their reports. The baker runs this before writing the runtime file.
+    // jobs, if given, spreads meshes and clips over its threads; palette bakes stay serial since
+    // they time themselves.
+    static void prepareAsset(const BakedAsset& asset, CharacterAsset& characterAsset, JobSystem* jobs = nullptr) {
+        if (asset.optimizeMeshes) {
+            int mesh = 0;
+            for (const auto& report : characterAsset.optimizeMeshes(jobs)) {
+                std::cout << "Optimized mesh " << mesh++ << " (" << report.vertexCount << " vertices, " << report.triangleCount
+                          << " triangles): ACMR " << report.acmrBefore << " -> " << report.acmrAfter << ", ATVR "
+                          << report.atvrBefore << " -> " << report.atvrAfter << std::endl;
+            }
+        }
+        if (asset.compression.enabled) {
+            for (const auto& report : characterAsset.compressClips(asset.compression, jobs)) {
+                std::cout << "Compressed clip '" << report.clipName << "': " << report.rawBytes << " -> "
+                          << report.compressedBytes << " bytes, max error rot " << report.maxRotationError
+                          << " rad, pos " << report.maxTranslationError << ", scale " << report.maxScaleError << std::endl;
+            }
+        }
+        for (const auto& bake : asset.paletteBakes) {
+            PaletteBakeReport report = characterAsset.bakePalettes(bake.clip, bake.framesPerSecond);
+            std::cout << "Baked palettes for clip '" << report.clipName << "': " << report.frameCount << " frames, "
+                      << report.bytes / 1024 << " KB shared, " << report.sampledNsPerUpdate << " -> "
+                      << report.bakedNsPerUpdate << " ns per instance update" << std::endl;
+        }
+    }
+
+    // State-to-clip mapping and hit colliders for one character instance; the state machine's
+    // asset must be set, colliders bind to its skeleton
+    static void configure(const BakedAsset& asset, FBXStateMachine& stateMachine, CharacterPhysics& physics) {
+        for (auto const& [name, index] : asset.states) {
+            if (name == "IDLE") stateMachine.setAnimationMapping(IDLE, index);
+            else if (name == "RUN") stateMachine.setAnimationMapping(RUN, index);
+            else if (name == "JUMP") stateMachine.setAnimationMapping(JUMP, index);
+        }
+
+        std::vector<Capsule> capsules;
+        for (auto& c : asset.colliders) {
+            capsules.push_back({c.bone, c.radius, c.height, c.damage});
+        }
+        physics.setupColliders(capsules, stateMachine.getSkeleton());
+    }
+};
+
+#endif
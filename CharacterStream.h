@@ -0,0 +1,203 @@
+#ifndef CHARACTER_STREAM_H
+#define CHARACTER_STREAM_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <iostream>
+#include <glm/glm.hpp>
+#include "AssetChunks.h"
+#include "ChunkFetcher.h"
+#include "CharacterAssetFile.h"
+#include "SkinnedRenderer.h"
+#include "TextureUpload.h"
+
+// Streams one character of a chunk manifest (AssetChunks) into a renderer. The core chunk comes
+// first; once it is in, the character animates and is drawn as one box per bone, skinned to that
+// bone. The meshes then replace the boxes, drawn with the renderer's untextured fallback until
+// each texture's first chunk (its small mip levels) arrives; larger levels follow one chunk at a
+// time and raise the texture's base level as they land. Everything runs from the fetcher's
+// poll() on the GL thread; the stream must outlive its pending fetches.
+class CharacterStream {
+public:
+    // Milliseconds from start() to each stage, -1 until it is reached
+    struct Timeline {
+        double coreMs = -1.0;
+        double meshesMs = -1.0;
+        double firstLevelsMs = -1.0;  // every texture sampleable at some level
+        double completeMs = -1.0;     // every chunk in
+    };
+
+    using CoreCallback = std::function<void(std::shared_ptr<const CharacterAsset> asset, const BakedAsset& config)>;
+
+    CharacterStream(ChunkFetcher& fetcher, SkinnedRenderer& renderer, const TextureUpload::Support& support)
+        : fetcher(fetcher), renderer(renderer), support(support) {}
+
+    // Deletes the streamed textures, so the GL context has to still be current
+    ~CharacterStream() {
+        for (StreamedTexture& texture : textures) {
+            if (texture.id != 0) glDeleteTextures(1, &texture.id);
+        }
+    }
+
+    CharacterStream(const CharacterStream&) = delete;
+    CharacterStream& operator=(const CharacterStream&) = delete;
+
+    // onCore hands over the animation data (and stored config) as soon as it is loaded
+    void start(const AssetChunks::Character& manifestEntry, CoreCallback onCore) {
+        character = manifestEntry;
+        coreCallback = std::move(onCore);
+        startTime = Clock::now();
+        fetcher.fetch(character.core.url, [this](bool ok, std::vector<uint8_t>& data) { receiveCore(ok, data); });
+    }
+
+    const Timeline& getTimeline() const { return timeline; }
+    bool isComplete() const { return timeline.completeMs >= 0.0; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct StreamedTexture {
+        size_t texture = 0;   // into character.textures
+        size_t payload = 0;   // into that texture's payloads
+        size_t nextChunk = 0;
+        GLuint id = 0;
+    };
+
+    double elapsedMs() const { return std::chrono::duration<double, std::milli>(Clock::now() - startTime).count(); }
+
+    void receiveCore(bool ok, std::vector<uint8_t>& data) {
+        BakedAsset config;
+        std::shared_ptr<CharacterAsset> asset = ok ? CharacterAssetFile::load(data.data(), data.size(), character.core.url, &config) : nullptr;
+        if (!asset) {
+            std::cerr << "Streaming " << character.name << " stopped: no core chunk" << std::endl;
+            return;
+        }
+        timeline.coreMs = elapsedMs();
+        renderer.setMeshes(boneBoxes(asset->getSkeleton()));
+        if (coreCallback) coreCallback(asset, config);
+
+        fetcher.fetch(character.meshes.url, [this](bool ok, std::vector<uint8_t>& data) { receiveMeshes(ok, data); });
+        for (size_t t = 0; t < character.textures.size(); t++) {
+            // The first payload this context can sample, as TextureUpload::choosePayload picks them
+            const auto& payloads = character.textures[t].payloads;
+            for (size_t p = 0; p < payloads.size(); p++) {
+                if (payloads[p].chunks.empty() || !TextureUpload::isSupported(payloads[p].format, support)) continue;
+                textures.push_back({t, p, 0, 0});
+                break;
+            }
+        }
+        for (size_t i = 0; i < textures.size(); i++) requestLevels(i);
+        updateProgress();
+    }
+
+    void receiveMeshes(bool ok, std::vector<uint8_t>& data) {
+        std::shared_ptr<CharacterAsset> meshes = ok ? CharacterAssetFile::load(data.data(), data.size(), character.meshes.url) : nullptr;
+        meshesDone = true;
+        if (meshes) {
+            renderer.setMeshes(meshes->getMeshes());
+            timeline.meshesMs = elapsedMs();
+        } else {
+            std::cerr << "Streaming " << character.name << ": no meshes chunk, keeping the placeholder" << std::endl;
+        }
+        updateProgress();
+    }
+
+    void requestLevels(size_t index) {
+        StreamedTexture& streamed = textures[index];
+        const AssetChunks::Payload& payload = character.textures[streamed.texture].payloads[streamed.payload];
+        fetcher.fetch(payload.chunks[streamed.nextChunk].chunk.url,
+                      [this, index](bool ok, std::vector<uint8_t>& data) { receiveLevels(index, ok, data); });
+    }
+
+    void receiveLevels(size_t index, bool ok, std::vector<uint8_t>& data) {
+        StreamedTexture& streamed = textures[index];
+        const AssetChunks::Texture& texture = character.textures[streamed.texture];
+        const AssetChunks::Payload& payload = texture.payloads[streamed.payload];
+        const AssetChunks::LevelChunk& levelChunk = payload.chunks[streamed.nextChunk];
+        std::vector<CharacterAsset::TextureLevel> levels;
+        if (ok) levels = AssetChunks::parseLevels(texture, payload, levelChunk, data.data(), data.size());
+        if (levels.empty()) {
+            // The texture keeps whatever levels it has; a texture with none stays untextured
+            std::cerr << "Streaming " << character.name << ": bad or missing chunk " << levelChunk.chunk.url << std::endl;
+            streamed.nextChunk = payload.chunks.size();
+            updateProgress();
+            return;
+        }
+
+        bool first = streamed.id == 0;
+        if (first) glGenTextures(1, &streamed.id);
+        TextureUpload::uploadLevels(streamed.id, payload.format, levelChunk.firstLevel, levels, texture.levelCount);
+        if (first) renderer.setTexture(texture.name, streamed.id);
+        if (++streamed.nextChunk < payload.chunks.size()) requestLevels(index);
+        updateProgress();
+    }
+
+    void updateProgress() {
+        bool allSampleable = true, allDone = meshesDone;
+        for (const StreamedTexture& streamed : textures) {
+            allSampleable = allSampleable && streamed.id != 0;
+            allDone = allDone && streamed.nextChunk == character.textures[streamed.texture].payloads[streamed.payload].chunks.size();
+        }
+        if (allSampleable && timeline.firstLevelsMs < 0.0) timeline.firstLevelsMs = elapsedMs();
+        if (allDone && timeline.completeMs < 0.0) {
+            timeline.completeMs = elapsedMs();
+            std::cout << "Streamed " << character.name << ": core at " << timeline.coreMs << " ms, meshes at " << timeline.meshesMs
+                      << " ms, first texture levels at " << timeline.firstLevelsMs << " ms, complete at " << timeline.completeMs
+                      << " ms (" << fetcher.getBytesReceived() / 1024 << " KB fetched)" << std::endl;
+        }
+    }
+
+    // Placeholder: a box around every bone's bind position, rigidly skinned to it. The vertices
+    // are the box corners mapped through the inverse bind palette, so skinning moves each box
+    // with its bone whatever the bone's offset matrix.
+    static std::vector<CharacterAsset::MeshData> boneBoxes(const Skeleton& skeleton) {
+        size_t boneCount = std::min<size_t>(skeleton.size(), 256);
+        std::vector<glm::mat4> world(skeleton.size()), palette(skeleton.size());
+        skeleton.evaluate(skeleton.bindPose.data(), world.data(), palette.data());
+
+        std::vector<glm::vec3> positions(boneCount);
+        glm::vec3 low(0.0f), high(0.0f);
+        for (size_t i = 0; i < boneCount; i++) {
+            positions[i] = glm::vec3(skeleton.globalInverseTransform * world[i][3]);
+            low = i == 0 ? positions[i] : glm::min(low, positions[i]);
+            high = i == 0 ? positions[i] : glm::max(high, positions[i]);
+        }
+        float halfSize = glm::max(0.015f * glm::length(high - low), 1e-3f);
+
+        static const uint16_t kBoxIndices[36] = {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+                                                 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3};
+        CharacterAsset::MeshData mesh;
+        for (size_t i = 0; i < boneCount; i++) {
+            glm::mat4 inverseBind = glm::inverse(palette[i]);
+            uint16_t first = (uint16_t)mesh.vertices.size();
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 offset((corner & 1) ? halfSize : -halfSize, (corner & 2) ? halfSize : -halfSize, (corner & 4) ? halfSize : -halfSize);
+                CharacterAsset::Vertex vertex = {};
+                vertex.position = glm::vec3(inverseBind * glm::vec4(positions[i] + offset, 1.0f));
+                // Corner-dependent UVs, so the untextured fallback shades the faces apart
+                vertex.uv[0] = (corner & 1) ? 0xFFFF : 0;
+                vertex.uv[1] = (corner & 2) ? 0xFFFF : 0;
+                vertex.boneIds[0] = (uint8_t)i;
+                vertex.weights[0] = 255;
+                mesh.vertices.push_back(vertex);
+            }
+            for (uint16_t index : kBoxIndices) mesh.indices.shortIndices.push_back((uint16_t)(first + index));
+        }
+        return {mesh};
+    }
+
+    ChunkFetcher& fetcher;
+    SkinnedRenderer& renderer;
+    TextureUpload::Support support;
+    AssetChunks::Character character;
+    CoreCallback coreCallback;
+    std::vector<StreamedTexture> textures;
+    bool meshesDone = false;
+    Clock::time_point startTime;
+    Timeline timeline;
+};
+
+#endif
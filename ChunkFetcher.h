@@ -0,0 +1,148 @@
+#ifndef CHUNK_FETCHER_H
+#define CHUNK_FETCHER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <cstdint>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+// Asynchronous fetches of streamed asset chunks by URL relative to a base. In the browser they
+// are HTTP requests (emscripten_async_wget_data, no preloaded file system needed); elsewhere the
+// base is a directory and one worker thread reads the files, optionally with a delay per chunk to
+// stand in for the network. Either way callbacks run from poll(), on the thread that calls it.
+class ChunkFetcher {
+public:
+    using Callback = std::function<void(bool ok, std::vector<uint8_t>& data)>;
+
+    explicit ChunkFetcher(std::string base, int delayMs = 0) : base(std::move(base)), delayMs(delayMs) {
+#ifndef __EMSCRIPTEN__
+        worker = std::thread([this] { workerLoop(); });
+#endif
+    }
+
+    ~ChunkFetcher() {
+#ifndef __EMSCRIPTEN__
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+#endif
+    }
+
+    ChunkFetcher(const ChunkFetcher&) = delete;
+    ChunkFetcher& operator=(const ChunkFetcher&) = delete;
+
+    void fetch(const std::string& url, Callback callback) {
+        pendingCount++;
+#ifdef __EMSCRIPTEN__
+        // The request object travels through the C callbacks and is freed in them
+        Request* request = new Request{this, url, std::move(callback), false, {}};
+        emscripten_async_wget_data((base + url).c_str(), request, onLoad, onError);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.push_back({this, url, std::move(callback), false, {}});
+        }
+        wake.notify_one();
+#endif
+    }
+
+    // Runs the callbacks of every fetch finished since the last call
+    void poll() {
+        std::deque<Request> done;
+        {
+#ifndef __EMSCRIPTEN__
+            std::lock_guard<std::mutex> lock(mutex);
+#endif
+            done.swap(finished);
+        }
+        for (Request& request : done) {
+            pendingCount--;
+            if (request.ok) bytesReceived += request.data.size();
+            request.callback(request.ok, request.data);
+        }
+    }
+
+    size_t pending() const { return pendingCount; }
+    size_t getBytesReceived() const { return bytesReceived; }
+
+private:
+    struct Request {
+        ChunkFetcher* fetcher = nullptr;
+        std::string url;
+        Callback callback;
+        bool ok = false;
+        std::vector<uint8_t> data;
+    };
+
+#ifdef __EMSCRIPTEN__
+    static void onLoad(void* arg, void* buffer, int size) {
+        Request* request = static_cast<Request*>(arg);
+        const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+        request->ok = true;
+        request->data.assign(bytes, bytes + size);
+        request->fetcher->finished.push_back(std::move(*request));
+        delete request;
+    }
+
+    static void onError(void* arg) {
+        Request* request = static_cast<Request*>(arg);
+        emscripten_log(EM_LOG_ERROR, "Failed to fetch %s", request->url.c_str());
+        request->fetcher->finished.push_back(std::move(*request));
+        delete request;
+    }
+#else
+    void workerLoop() {
+        while (true) {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !requests.empty(); });
+                if (stopping) return;
+                request = std::move(requests.front());
+                requests.pop_front();
+            }
+            if (delayMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+            std::ifstream in(base + request.url, std::ios::binary | std::ios::ate);
+            if (in) {
+                request.data.resize((size_t)in.tellg());
+                in.seekg(0);
+                in.read(reinterpret_cast<char*>(request.data.data()), (std::streamsize)request.data.size());
+                request.ok = (bool)in;
+            }
+            if (!request.ok) std::cerr << "Failed to read " << base + request.url << std::endl;
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.push_back(std::move(request));
+        }
+    }
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> requests;
+    bool stopping = false;
+#endif
+
+    std::string base;
+    int delayMs;
+    std::deque<Request> finished;
+    size_t pendingCount = 0;
+    size_t bytesReceived = 0;
+};
+
+#endif
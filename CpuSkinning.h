@@ -0,0 +1,102 @@
+#ifndef CPU_SKINNING_H
+#define CPU_SKINNING_H
+
+#include <span>
+#include <cstddef>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "CharacterAsset.h"
+#include "JobSystem.h"
+#include "SimdMath.h"
+
+// CPU version of the skinning vertex shader, for hit validation, bounds and dumps where there is
+// no GPU. Uses the same 4-influence weighting as SkinnedRenderer's shader: unorm8 weights are
+// decoded but not renormalized, and a vertex whose used weights sum below 0.01 keeps its bind
+// position.
+class CpuSkinning {
+public:
+    static constexpr int kMaxBones = 256;  // size of the shaders' u_bones array
+
+    // Skins vertices [begin, end) of the mesh into out[begin, end). Influences whose bone id is
+    // beyond the palette are ignored.
+    static void skinRange(const CharacterAsset::MeshData& mesh, std::span<const glm::mat4> palette,
+                          size_t begin, size_t end, glm::vec3* out) {
+        const int boneLimit = (int)std::min<size_t>(palette.size(), kMaxBones);
+        const glm::mat4* bones = palette.data();
+        for (size_t v = begin; v < end; v++) {
+            const CharacterAsset::Vertex& vertex = mesh.vertices[v];
+#if SIMD_MATH_AVX2 || SIMD_MATH_SSE
+            __m128 px = _mm_set1_ps(vertex.position.x);
+            __m128 py = _mm_set1_ps(vertex.position.y);
+            __m128 pz = _mm_set1_ps(vertex.position.z);
+            __m128 pos = _mm_setzero_ps();
+            float totalWeight = 0.0f;
+            for (int i = 0; i < 4; i++) {
+                int id = vertex.boneIds[i];
+                if (id >= boneLimit) continue;
+                float weight = vertex.weights[i] * CharacterAsset::kWeightScale;
+                const float* m = &bones[id][0][0];
+                __m128 p = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m), px), _mm_mul_ps(_mm_loadu_ps(m + 4), py));
+                p = _mm_add_ps(p, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), pz), _mm_loadu_ps(m + 12)));
+                pos = _mm_add_ps(pos, _mm_mul_ps(_mm_set1_ps(weight), p));
+                totalWeight += weight;
+            }
+            float result[4];
+            _mm_storeu_ps(result, pos);
+            out[v] = totalWeight < 0.01f ? vertex.position : glm::vec3(result[0], result[1], result[2]);
+#elif SIMD_MATH_WASM
+            v128_t px = wasm_f32x4_splat(vertex.position.x);
+            v128_t py = wasm_f32x4_splat(vertex.position.y);
+            v128_t pz = wasm_f32x4_splat(vertex.position.z);
+            v128_t pos = wasm_f32x4_splat(0.0f);
+            float totalWeight = 0.0f;
+            for (int i = 0; i < 4; i++) {
+                int id = vertex.boneIds[i];
+                if (id >= boneLimit) continue;
+                float weight = vertex.weights[i] * CharacterAsset::kWeightScale;
+                const float* m = &bones[id][0][0];
+                v128_t p = wasm_f32x4_add(wasm_f32x4_mul(wasm_v128_load(m), px), wasm_f32x4_mul(wasm_v128_load(m + 4), py));
+                p = wasm_f32x4_add(p, wasm_f32x4_add(wasm_f32x4_mul(wasm_v128_load(m + 8), pz), wasm_v128_load(m + 12)));
+                pos = wasm_f32x4_add(pos, wasm_f32x4_mul(wasm_f32x4_splat(weight), p));
+                totalWeight += weight;
+            }
+            out[v] = totalWeight < 0.01f ? vertex.position
+                                         : glm::vec3(wasm_f32x4_extract_lane(pos, 0), wasm_f32x4_extract_lane(pos, 1),
+                                                     wasm_f32x4_extract_lane(pos, 2));
+#else
+            glm::vec4 pos(0.0f);
+            float totalWeight = 0.0f;
+            for (int i = 0; i < 4; i++) {
+                int id = vertex.boneIds[i];
+                if (id >= boneLimit) continue;
+                float weight = vertex.weights[i] * CharacterAsset::kWeightScale;
+                pos += weight * (bones[id] * glm::vec4(vertex.position, 1.0f));
+                totalWeight += weight;
+            }
+            out[v] = totalWeight < 0.01f ? vertex.position : glm::vec3(pos);
+#endif
+        }
+    }
+
+    // Skins the whole mesh into out (mesh.vertices.size() entries), split into chunks of
+    // chunkSize vertices across the job system's threads. jobs may be null to run serially.
+    static void skin(const CharacterAsset::MeshData& mesh, std::span<const glm::mat4> palette, glm::vec3* out,
+                     JobSystem* jobs, size_t chunkSize = 2048) {
+        auto skinChunk = [&](size_t begin, size_t end) { skinRange(mesh, palette, begin, end, out); };
+        if (jobs) jobs->parallelFor(mesh.vertices.size(), chunkSize, skinChunk);
+        else skinChunk(0, mesh.vertices.size());
+    }
+
+    // Axis-aligned bounds of skinned positions; returns false for an empty range
+    static bool bounds(const glm::vec3* positions, size_t count, glm::vec3& outMin, glm::vec3& outMax) {
+        if (count == 0) return false;
+        outMin = outMax = positions[0];
+        for (size_t i = 1; i < count; i++) {
+            outMin = glm::min(outMin, positions[i]);
+            outMax = glm::max(outMax, positions[i]);
+        }
+        return true;
+    }
+};
+
+#endif
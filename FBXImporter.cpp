@@ -0,0 +1,274 @@
+#include "FBXImporter.h"
+#include <iostream>
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <glm/gtc/type_ptr.hpp>
+
+static glm::vec3 toGlm(const aiVector3D& v) { return glm::vec3(v.x, v.y, v.z); }
+static glm::quat toGlm(const aiQuaternion& q) { return glm::quat(q.w, q.x, q.y, q.z); }
+
+std::shared_ptr<CharacterAsset> FBXImporter::load(const std::string& path, JobSystem* jobs, ImportTimings* timings) {
+    using Clock = std::chrono::steady_clock;
+    auto msSince = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    ImportTimings localTimings;
+    ImportTimings& t = timings ? *timings : localTimings;
+    t = ImportTimings();
+    auto importStart = Clock::now();
+
+    std::string fbxDirectory = "";
+    size_t lastSlash = path.find_last_of("/\\");
+    if (lastSlash != std::string::npos) {
+        fbxDirectory = path.substr(0, lastSlash + 1);
+    }
+
+    Assimp::Importer importer;
+    auto stageStart = Clock::now();
+    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices | aiProcess_LimitBoneWeights);
+    t.readMs = msSince(stageStart);
+    if (!scene) {
+        std::cerr << "Assimp error: " << importer.GetErrorString() << std::endl;
+        return nullptr;
+    }
+
+    // Everything is copied out, so the asset outlives the importer and its scene
+    auto asset = std::make_shared<CharacterAsset>();
+    stageStart = Clock::now();
+    processNode(*asset, scene->mRootNode, -1);
+    t.skeletonMs = msSince(stageStart);
+
+    // The skeleton is final now, so meshes, clips and embedded textures only read shared data
+    // and each writes its own preallocated slot
+    const BoneMapping boneMapping = [&] {
+        BoneMapping mapping;
+        for (size_t i = 0; i < asset->skeleton.size(); i++) mapping[asset->skeleton.names[i]] = (int)i;
+        return mapping;
+    }();
+    const size_t meshCount = scene->mNumMeshes, clipCount = scene->mNumAnimations, textureCount = scene->mNumTextures;
+    asset->meshes.resize(meshCount);
+    asset->clips.resize(clipCount);
+    asset->textures.resize(textureCount);
+    std::vector<OffsetMatrices> meshOffsets(meshCount);
+    std::vector<double> taskMs(meshCount + clipCount + textureCount, 0.0);
+
+    auto extract = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            auto taskStart = Clock::now();
+            if (i < meshCount) {
+                importMesh(scene, scene->mMeshes[i], boneMapping, fbxDirectory, asset->meshes[i], meshOffsets[i]);
+            } else if (i < meshCount + clipCount) {
+                size_t clip = i - meshCount;
+                importClip(scene->mAnimations[clip], boneMapping, asset->skeleton.size(), asset->clips[clip]);
+            } else {
+                size_t texture = i - meshCount - clipCount;
+                importTexture(scene->mTextures[texture], asset->textures[texture]);
+            }
+            taskMs[i] = msSince(taskStart);
+        }
+    };
+    stageStart = Clock::now();
+    if (jobs) jobs->parallelFor(taskMs.size(), 1, extract);
+    else extract(0, taskMs.size());
+    t.extractMs = msSince(stageStart);
+
+    for (size_t i = 0; i < taskMs.size(); i++) {
+        if (i < meshCount) t.meshesMs += taskMs[i];
+        else if (i < meshCount + clipCount) t.clipsMs += taskMs[i];
+        else t.texturesMs += taskMs[i];
+    }
+
+    // Bind matrices found on the meshes, applied in mesh order as the serial import did
+    for (const OffsetMatrices& offsets : meshOffsets) {
+        for (const auto& [bone, matrix] : offsets) asset->skeleton.offsetMatrices[bone] = matrix;
+    }
+
+    aiMatrix4x4 globalTransform = scene->mRootNode->mTransformation;
+    globalTransform.Inverse();
+    asset->skeleton.globalInverseTransform = glm::transpose(glm::make_mat4(&globalTransform.a1));
+    t.totalMs = msSince(importStart);
+    return asset;
+}
+
+// Depth-first pre-order, so parents are always added before their children
+void FBXImporter::processNode(CharacterAsset& asset, const aiNode* node, int parentIdx) {
+    std::string name = node->mName.C_Str();
+    aiVector3D scaling, position;
+    aiQuaternion rotation;
+    node->mTransformation.Decompose(scaling, rotation, position);
+    BoneTransform bindLocal;
+    bindLocal.translation = toGlm(position);
+    bindLocal.rotation = toGlm(rotation);
+    bindLocal.scale = toGlm(scaling);
+    int currentIdx = asset.skeleton.addBone(name, parentIdx, bindLocal);
+
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        processNode(asset, node->mChildren[i], currentIdx);
+    }
+}
+
+void FBXImporter::importMesh(const aiScene* scene, const aiMesh* mesh, const BoneMapping& boneMapping,
+                             const std::string& fbxDirectory, CharacterAsset::MeshData& meshData, OffsetMatrices& offsets) {
+    using Vertex = CharacterAsset::Vertex;
+
+    if (mesh->mMaterialIndex < scene->mNumMaterials) {
+        const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        aiString path;
+        bool found = false;
+        if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS) found = true;
+        else if (material->GetTexture(aiTextureType_BASE_COLOR, 0, &path) == AI_SUCCESS) found = true;
+        else if (material->GetTexture(aiTextureType_EMISSIVE, 0, &path) == AI_SUCCESS) found = true;
+        else if (material->GetTexture(aiTextureType_AMBIENT, 0, &path) == AI_SUCCESS) found = true;
+        else if (material->GetTexture(aiTextureType_UNKNOWN, 0, &path) == AI_SUCCESS) found = true;
+
+        if (found) {
+            std::string texPath = path.C_Str();
+            if (texPath.size() > 0 && texPath[0] == '*') {
+                meshData.texturePath = texPath;
+            } else {
+                // Replace backslashes with forward slashes for cross-platform
+                for (auto& c : texPath) if (c == '\\') c = '/';
+
+                // Extract filename only for potential absolute path issues
+                size_t lastSlash = texPath.find_last_of('/');
+                std::string filename = (lastSlash == std::string::npos) ? texPath : texPath.substr(lastSlash + 1);
+
+                meshData.texturePath = fbxDirectory + filename;
+            }
+        }
+    }
+
+    // Extract vertices
+    const unsigned int vertexCount = mesh->mNumVertices;
+    meshData.vertices.assign(vertexCount, Vertex{});
+    std::vector<glm::vec2> uvs(vertexCount, glm::vec2(0.0f));
+    const bool hasUVs = mesh->HasTextureCoords(0);
+    for (unsigned int j = 0; j < vertexCount; j++) {
+        meshData.vertices[j].position = glm::vec3(mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z);
+        if (hasUVs) uvs[j] = glm::vec2(mesh->mTextureCoords[0][j].x, mesh->mTextureCoords[0][j].y);
+    }
+    packUVs(meshData, uvs);
+
+    // Extract indices
+    std::vector<uint32_t> indices;
+    indices.reserve((size_t)mesh->mNumFaces * 3);
+    for (unsigned int j = 0; j < mesh->mNumFaces; j++) {
+        const aiFace& face = mesh->mFaces[j];
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+    }
+    meshData.indices.assign(indices, vertexCount);
+
+    // Extract bone weights. Influences on bones outside the skeleton (or beyond the shader's
+    // 256) keep a zero weight, which the shader skips like it used to skip their ids.
+    std::vector<int> boneCount(vertexCount, 0);
+    std::vector<glm::ivec4> boneIds(vertexCount, glm::ivec4(0));
+    std::vector<glm::vec4> weights(vertexCount, glm::vec4(0.0f));
+    for (unsigned int j = 0; j < mesh->mNumBones; j++) {
+        const aiBone* aiBonePtr = mesh->mBones[j];
+        int boneIdx = -1;
+        auto it = boneMapping.find(aiBonePtr->mName.C_Str());
+        if (it != boneMapping.end()) {
+            boneIdx = it->second;
+            offsets.push_back({boneIdx, glm::transpose(glm::make_mat4(&aiBonePtr->mOffsetMatrix.a1))});
+        }
+
+        for (unsigned int k = 0; k < aiBonePtr->mNumWeights; k++) {
+            unsigned int vertexId = aiBonePtr->mWeights[k].mVertexId;
+            float weight = aiBonePtr->mWeights[k].mWeight;
+            if (boneCount[vertexId] < 4) {
+                bool usable = boneIdx >= 0 && boneIdx < 256;
+                boneIds[vertexId][boneCount[vertexId]] = usable ? boneIdx : 0;
+                weights[vertexId][boneCount[vertexId]] = usable ? weight : 0.0f;
+                boneCount[vertexId]++;
+            }
+        }
+    }
+    for (unsigned int j = 0; j < vertexCount; j++) {
+        packInfluences(boneIds[j], weights[j], meshData.vertices[j]);
+    }
+}
+
+// UVs are quantized over the mesh's own range, so tiled (outside [0, 1]) coordinates survive
+void FBXImporter::packUVs(CharacterAsset::MeshData& mesh, const std::vector<glm::vec2>& uvs) {
+    if (uvs.empty()) return;
+    glm::vec2 lo = uvs[0], hi = uvs[0];
+    for (const glm::vec2& uv : uvs) {
+        lo = glm::min(lo, uv);
+        hi = glm::max(hi, uv);
+    }
+    mesh.uvOffset = lo;
+    mesh.uvScale = hi - lo;
+    for (size_t i = 0; i < uvs.size(); i++) {
+        for (int c = 0; c < 2; c++) {
+            float normalized = mesh.uvScale[c] > 0.0f ? (uvs[i][c] - lo[c]) / mesh.uvScale[c] : 0.0f;
+            mesh.vertices[i].uv[c] = (uint16_t)std::lround(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f);
+        }
+    }
+}
+
+// Rounds each weight to unorm8 and puts the rounding residue on the largest one, so the
+// quantized weights add up to the same total as the source ones
+void FBXImporter::packInfluences(const glm::ivec4& boneIds, const glm::vec4& weights, CharacterAsset::Vertex& out) {
+    int quantized[4];
+    int sum = 0, largest = 0;
+    float total = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        quantized[i] = (int)std::lround(std::clamp(weights[i], 0.0f, 1.0f) * 255.0f);
+        sum += quantized[i];
+        total += std::max(weights[i], 0.0f);
+        if (weights[i] > weights[largest]) largest = i;
+    }
+    int target = (int)std::lround(std::min(total, 1.0f) * 255.0f);
+    quantized[largest] = std::clamp(quantized[largest] + target - sum, 0, 255);
+    for (int i = 0; i < 4; i++) {
+        out.boneIds[i] = (uint8_t)boneIds[i];
+        out.weights[i] = (uint8_t)quantized[i];
+    }
+}
+
+// Keys are copied into the engine's own types, times kept in ticks
+void FBXImporter::importClip(const aiAnimation* animation, const BoneMapping& boneMapping, size_t boneCount,
+                             CharacterAsset::CompiledClip& clip) {
+    clip.name = animation->mName.C_Str();
+    clip.duration = (float)animation->mDuration;
+    clip.ticksPerSecond = animation->mTicksPerSecond != 0 ? (float)animation->mTicksPerSecond : 25.0f;
+    clip.channelForBone.assign(boneCount, -1);
+    clip.channels.reserve(animation->mNumChannels);
+    for (unsigned int c = 0; c < animation->mNumChannels; c++) {
+        const aiNodeAnim* pNodeAnim = animation->mChannels[c];
+        auto it = boneMapping.find(pNodeAnim->mNodeName.C_Str());
+        if (it == boneMapping.end()) continue;
+
+        RawChannel channel;
+        channel.positions.reserve(pNodeAnim->mNumPositionKeys);
+        channel.rotations.reserve(pNodeAnim->mNumRotationKeys);
+        channel.scalings.reserve(pNodeAnim->mNumScalingKeys);
+        for (unsigned int k = 0; k < pNodeAnim->mNumPositionKeys; k++) {
+            const aiVectorKey& key = pNodeAnim->mPositionKeys[k];
+            channel.positions.push_back({(float)key.mTime, toGlm(key.mValue)});
+        }
+        for (unsigned int k = 0; k < pNodeAnim->mNumRotationKeys; k++) {
+            const aiQuatKey& key = pNodeAnim->mRotationKeys[k];
+            channel.rotations.push_back({(float)key.mTime, toGlm(key.mValue)});
+        }
+        for (unsigned int k = 0; k < pNodeAnim->mNumScalingKeys; k++) {
+            const aiVectorKey& key = pNodeAnim->mScalingKeys[k];
+            channel.scalings.push_back({(float)key.mTime, toGlm(key.mValue)});
+        }
+        clip.channelForBone[it->second] = (int)clip.channels.size();
+        clip.channels.push_back(std::move(channel));
+    }
+}
+
+void FBXImporter::importTexture(const aiTexture* texture, CharacterAsset::EmbeddedTexture& embedded) {
+    embedded.path = texture->mFilename.C_Str();
+    embedded.formatHint = texture->achFormatHint;
+    embedded.width = (int)texture->mWidth;
+    embedded.height = (int)texture->mHeight;
+    size_t bytes = texture->mHeight == 0 ? texture->mWidth : (size_t)texture->mWidth * texture->mHeight * 4;
+    const uint8_t* data = (const uint8_t*)texture->pcData;
+    embedded.data.assign(data, data + bytes);
+}
@@ -0,0 +1,58 @@
+#ifndef FBX_IMPORTER_H
+#define FBX_IMPORTER_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstdint>
+#include "CharacterAsset.h"
+#include "JobSystem.h"
+
+struct aiScene;
+struct aiNode;
+struct aiMesh;
+struct aiAnimation;
+struct aiTexture;
+
+// Per-stage wall time of one import. Meshes, clips and embedded textures are extracted
+// concurrently, so their times are summed over the items of each stage (CPU time) and
+// extractMs is the wall time of the whole concurrent batch.
+struct ImportTimings {
+    double readMs = 0.0;      // Assimp parse and post-processing
+    double skeletonMs = 0.0;
+    double meshesMs = 0.0;
+    double clipsMs = 0.0;
+    double texturesMs = 0.0;  // embedded texture copies
+    double extractMs = 0.0;
+    double totalMs = 0.0;
+};
+
+// Assimp import of an FBX (or any format Assimp reads) into a CharacterAsset. Only the editor
+// and the baker link this; the runtimes load the baked binary through CharacterAssetFile.
+class FBXImporter {
+public:
+    // Bump whenever the extracted data changes for the same input, so import caches miss
+    static constexpr uint32_t kVersion = 1;
+
+    // Returns nullptr if the import fails. With jobs, every mesh, clip and embedded texture is
+    // extracted as its own task; timings, if given, receives the stage breakdown.
+    static std::shared_ptr<CharacterAsset> load(const std::string& path, JobSystem* jobs = nullptr,
+                                                ImportTimings* timings = nullptr);
+
+private:
+    using BoneMapping = std::map<std::string, int>;
+    using OffsetMatrices = std::vector<std::pair<int, glm::mat4>>;
+
+    static void processNode(CharacterAsset& asset, const aiNode* node, int parentIdx);
+    static void importMesh(const aiScene* scene, const aiMesh* mesh, const BoneMapping& boneMapping,
+                           const std::string& fbxDirectory, CharacterAsset::MeshData& meshData, OffsetMatrices& offsets);
+    static void importClip(const aiAnimation* animation, const BoneMapping& boneMapping, size_t boneCount,
+                           CharacterAsset::CompiledClip& clip);
+    static void importTexture(const aiTexture* texture, CharacterAsset::EmbeddedTexture& embedded);
+    static void packUVs(CharacterAsset::MeshData& mesh, const std::vector<glm::vec2>& uvs);
+    static void packInfluences(const glm::ivec4& boneIds, const glm::vec4& weights, CharacterAsset::Vertex& out);
+};
+
+#endif
@@ -3,88 +3,124 @@
 
 #include <string>
 #include <vector>
-#include <map>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
+#include <memory>
+#include <span>
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
+#include "Skeleton.h"
+#include "AnimationClip.h"
+#include "CharacterAsset.h"
+#include "JobSystem.h"
+#include "AnimationLayers.h"
 
 enum State { IDLE, RUN, JUMP };
 
-struct Bone {
-    std::string name;
-    glm::mat4 offsetMatrix;
-    glm::mat4 localTransform;
-    glm::mat4 finalTransform;
-    int parentIndex = -1;
-    std::vector<int> children;
-    glm::mat4 worldTransform = glm::mat4(1.0f);
+// How an instance plays clips that have baked palettes (CharacterAsset::bakePalettes)
+enum class BakedPlayback {
+    Disabled,      // always sample and evaluate
+    Nearest,       // copy the closest baked frame
+    Interpolated   // lerp between the two surrounding frames
 };
 
+// Per-character animation instance. Holds only playback state and the output pose; skeleton,
+// meshes and clips come from a CharacterAsset shared between all instances of that type.
 class FBXStateMachine {
 public:
-    void loadFBX(std::string path);
+    using Vertex = CharacterAsset::Vertex;
+    using MeshData = CharacterAsset::MeshData;
+    using Metadata = CharacterAsset::Metadata;
+    using CompiledClip = CharacterAsset::CompiledClip;
+
+    FBXStateMachine() = default;
+    explicit FBXStateMachine(std::shared_ptr<const CharacterAsset> asset) { setAsset(std::move(asset)); }
+
+    // Loads a baked .character file through AssetDatabase::instance(), so every instance loading
+    // the same path shares one asset
+    void loadBaked(const std::string& path);
+    void setAsset(std::shared_ptr<const CharacterAsset> asset);
+    const std::shared_ptr<const CharacterAsset>& getAsset() const { return asset; }
+
     void setState(State state);
     void setAnimationMapping(State state, int clipIndex);
     void update(float dt);
+
+    // Baked palettes are used while the state clip plays on its own: no crossfade and no
+    // active layers. Anything else falls back to sampling for that update.
+    void setBakedPlayback(BakedPlayback mode) { bakedPlayback = mode; }
+    BakedPlayback getBakedPlayback() const { return bakedPlayback; }
+
+    // Clip layers (aiming, upper-body actions) blended over the state clip every update.
+    // Reset whenever the asset changes.
+    AnimationLayerStack& getLayers() { return layers; }
+    const AnimationLayerStack& getLayers() const { return layers; }
+
+    // Restricts sampling and blending to a sorted list of bone indices (animation LOD); the other
+    // bones hold their bind pose. The list must outlive its use here; nullptr samples every bone.
+    void setSampledBones(const std::vector<int>* bones);
+    const std::vector<int>* getSampledBones() const { return sampledBones; }
+
+    // Updates many instances (sampling, hierarchy and palette) spread over the job system's
+    // threads. Instances are independent, so the result is identical for any thread count;
+    // jobs may be null to update serially on the calling thread.
+    static void updateBatch(FBXStateMachine* const* instances, size_t count, float dt, JobSystem* jobs);
     
-    std::vector<glm::mat4> getFinalBoneMatrices() { return finalBoneMatrices; }
-    const std::vector<Bone>& getBones() const { return bones; }
-
-    struct Vertex {
-        glm::vec3 position;
-        glm::vec2 uv;
-        glm::ivec4 boneIds;
-        glm::vec4 weights;
-    };
+    // Skinning palette for rendering, one matrix per bone. A view into the instance's own buffer,
+    // valid until the next update (single-buffered) or the next swapPaletteBuffers().
+    std::span<const glm::mat4> getFinalBoneMatrices() const { return paletteBuffers[readIndex]; }
 
-    struct MeshData {
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::string texturePath;
-    };
+    // Double-buffered mode lets a render thread read frame N's palette while update() writes
+    // frame N+1 into the other buffer, without copies or locks. The application calls
+    // swapPaletteBuffers() at its frame sync point, once the reader is done with the old frame.
+    // Without an update() since the last swap (an LOD-skipped frame) the swap does nothing, so
+    // the reader stays on the newest frame.
+    void setDoubleBuffered(bool enabled);
+    bool isDoubleBuffered() const { return readIndex != writeIndex; }
+    void swapPaletteBuffers() {
+        if (latestIndex != readIndex) std::swap(readIndex, writeIndex);
+    }
+
+    // Latest evaluated pose, for simulation-side queries
+    BoneList getBones() const { return BoneList(getSkeleton(), worldTransforms.data(), paletteBuffers[latestIndex].data()); }
+    const Skeleton& getSkeleton() const;
 
-    const std::vector<MeshData>& getMeshes() const { return meshes; }
+    const std::vector<MeshData>& getMeshes() const;
     
     // Get embedded texture data
-    const aiTexture* getEmbeddedTexture(const std::string& path) const;
+    const CharacterAsset::EmbeddedTexture* getEmbeddedTexture(const std::string& path) const;
 
-    struct Metadata {
-        int numAnimations = 0;
-        int numMeshes = 0;
-        int numBones = 0;
-        std::vector<std::string> animationNames;
-    };
     Metadata getMetadata() const;
 
+    // One playing clip instance: the state it belongs to, its time and key cursors
+    struct ClipPlayback {
+        State state = IDLE;
+        float time = 0.0f;
+        std::vector<KeyCursor> cursors;
+    };
+
 private:
-    void processNode(const aiNode* node, int parentIdx);
-    void readNodeHierarchy(float animationTime, const aiNode* pNode, const glm::mat4& parentTransform, const aiAnimation* pAnimation);
-    const aiNodeAnim* findNodeAnim(const aiAnimation* pAnimation, const std::string& nodeName);
-    void calcInterpolatedRotation(aiQuaternion& out, float animationTime, const aiNodeAnim* pNodeAnim);
-    void calcInterpolatedPosition(aiVector3D& out, float animationTime, const aiNodeAnim* pNodeAnim);
-    void calcInterpolatedScaling(aiVector3D& out, float animationTime, const aiNodeAnim* pNodeAnim);
-    unsigned int findRotation(float animationTime, const aiNodeAnim* pNodeAnim);
-    unsigned int findPosition(float animationTime, const aiNodeAnim* pNodeAnim);
-    unsigned int findScaling(float animationTime, const aiNodeAnim* pNodeAnim);
-
-    std::string fbxDirectory;
-    Assimp::Importer importer;
-    const aiScene* scene = nullptr;
-    std::vector<Bone> bones;
-    std::map<std::string, int> boneMapping;
-    std::vector<MeshData> meshes;
-    std::vector<glm::mat4> finalBoneMatrices;
-    glm::mat4 globalInverseTransform;
+    const CompiledClip* clipForState(State state) const;
+    float advancePlayback(ClipPlayback& playback, const CompiledClip& clip, float dt);
+
+    std::shared_ptr<const CharacterAsset> asset;
+
+    // Current pose, one entry per skeleton bone; paletteBuffers hold the skinning palette (the
+    // second one only in double-buffered mode). All sized in setAsset so update() never allocates.
+    std::vector<BoneTransform> localPoses;
+    std::vector<BoneTransform> crossfadePose;
+    std::vector<glm::mat4> worldTransforms;
+    std::vector<glm::mat4> paletteBuffers[2];
+    int readIndex = 0;
+    int writeIndex = 0;
+    int latestIndex = 0;  // buffer holding the pose in worldTransforms
     
-    State currentState = IDLE;
-    float currentTime = 0.0f;
-    std::map<State, int> stateToClipIndex;
+    const std::vector<int>* sampledBones = nullptr;
+    AnimationLayerStack layers;
+    BakedPlayback bakedPlayback = BakedPlayback::Interpolated;
+
+    ClipPlayback current;
+    int stateToClipIndex[JUMP + 1] = {0, 0, 0};
 
     // Crossfade support
-    State nextState = IDLE;
+    ClipPlayback next;
     float crossfadeTime = 0.0f;
     float crossfadeDuration = 0.2f;
     bool isCrossfading = false;
@@ -0,0 +1,170 @@
+#include "ImportCache.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include "CharacterAssetFile.h"
+#include "TextureBaker.h"
+
+static constexpr uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+// FNV-1a over whole 64-bit words, with each word scrambled first so the multiply sees all its bits
+static uint64_t mixWord(uint64_t hash, uint64_t word) {
+    word *= 0x9e3779b97f4a7c15ull;
+    word ^= word >> 32;
+    return (hash ^ word) * 0x100000001b3ull;
+}
+
+static uint64_t finalizeHash(uint64_t hash, uint64_t length) {
+    hash = mixWord(hash, length);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static std::string toHex(uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", (unsigned long long)value);
+    return text;
+}
+
+bool ImportCache::hashFile(const std::string& path, uint64_t& hash) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    // Whole words per chunk, so only the final read can end mid-word
+    std::vector<char> buffer(1 << 20);
+    uint64_t h = kHashSeed, length = 0;
+    while (in) {
+        in.read(buffer.data(), (std::streamsize)buffer.size());
+        size_t count = (size_t)in.gcount();
+        length += count;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, buffer.data() + i, 8);
+            h = mixWord(h, word);
+        }
+        if (i < count) {
+            uint64_t word = 0;
+            std::memcpy(&word, buffer.data() + i, count - i);
+            h = mixWord(h, word);
+        }
+    }
+    if (in.bad()) return false;
+    hash = finalizeHash(h, length);
+    return true;
+}
+
+// Everything besides the source bytes that changes what an entry holds
+uint64_t ImportCache::settingsHash() const {
+    std::string settings = "fbx=" + std::to_string(FBXImporter::kVersion) + ";file=" + std::to_string(CharacterAssetFile::kVersion) + ";textures=";
+    for (const std::string& format : textureFormats) settings += format + ",";
+    uint64_t h = kHashSeed;
+    for (char c : settings) h = mixWord(h, (unsigned char)c);
+    return finalizeHash(h, settings.size());
+}
+
+// Entries are named <source name>-<path hash>-<key>, so each source file keeps only its latest
+// import and same-named sources in other directories keep theirs
+std::string ImportCache::entryPrefix(const std::string& sourcePath) const {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    fs::path absolute = fs::absolute(sourcePath, error);
+    std::string location = (error ? fs::path(sourcePath) : absolute).lexically_normal().generic_string();
+    uint64_t h = kHashSeed;
+    for (char c : location) h = mixWord(h, (unsigned char)c);
+    return (fs::path(directory) / (fs::path(sourcePath).stem().string() + "-" + toHex(finalizeHash(h, location.size())) + "-")).string();
+}
+
+// <prefix><16 hex digits>.character or .deps: an entry of this source, not of one whose name
+// merely starts the same way
+static bool isEntryOf(const std::string& fileName, const std::string& prefix) {
+    if (fileName.compare(0, prefix.size(), prefix) != 0) return false;
+    std::string rest = fileName.substr(prefix.size());
+    if (rest.size() < 16) return false;
+    for (size_t i = 0; i < 16; i++) {
+        if (!std::isxdigit((unsigned char)rest[i])) return false;
+    }
+    std::string extension = rest.substr(16);
+    return extension == ".character" || extension == ".deps";
+}
+
+bool ImportCache::dependenciesMatch(const std::string& depsPath) const {
+    std::ifstream in(depsPath);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.size() < 18 || line[16] != ' ') return false;
+        uint64_t recorded = std::strtoull(line.substr(0, 16).c_str(), nullptr, 16);
+        uint64_t current = 0;
+        if (!hashFile(line.substr(17), current) || current != recorded) return false;
+    }
+    return true;
+}
+
+void ImportCache::store(const std::string& sourcePath, const std::string& entryPath, const CharacterAsset& asset,
+                        const std::vector<Dependency>& dependencies) const {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    fs::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Cannot create import cache " << directory << ": " << error.message() << std::endl;
+        return;
+    }
+    std::string prefix = fs::path(entryPrefix(sourcePath)).filename().string();
+    for (const auto& file : fs::directory_iterator(directory, error)) {
+        if (isEntryOf(file.path().filename().string(), prefix)) fs::remove(file.path(), error);
+    }
+
+    // The deps file goes last: an entry without one is never read, so a failed write just misses
+    if (!CharacterAssetFile::save(entryPath, asset, BakedAsset())) return;
+    std::ofstream deps(entryPath.substr(0, entryPath.size() - std::strlen(".character")) + ".deps");
+    for (const Dependency& dependency : dependencies) deps << toHex(dependency.hash) << " " << dependency.path << "\n";
+}
+
+std::shared_ptr<CharacterAsset> ImportCache::load(const std::string& sourcePath, JobSystem* jobs, ImportCacheReport* report, bool reimport) const {
+    using Clock = std::chrono::steady_clock;
+    auto msSince = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    ImportCacheReport localReport;
+    ImportCacheReport& r = report ? *report : localReport;
+    r = ImportCacheReport();
+
+    auto start = Clock::now();
+    uint64_t sourceHash = 0;
+    if (!hashFile(sourcePath, sourceHash)) return FBXImporter::load(sourcePath, jobs, &r.import);  // logs the error
+    std::string key = toHex(mixWord(sourceHash, settingsHash()));
+    r.entryPath = entryPrefix(sourcePath) + key + ".character";
+    std::string depsPath = entryPrefix(sourcePath) + key + ".deps";
+    bool fresh = !reimport && dependenciesMatch(depsPath);
+    r.hashMs = msSince(start);
+
+    if (fresh) {
+        start = Clock::now();
+        std::shared_ptr<CharacterAsset> asset = CharacterAssetFile::load(r.entryPath);
+        r.cacheReadMs = msSince(start);
+        if (asset) {
+            r.hit = true;
+            return asset;
+        }
+    }
+
+    std::shared_ptr<CharacterAsset> asset = FBXImporter::load(sourcePath, jobs, &r.import);
+    if (!asset) return nullptr;
+
+    start = Clock::now();
+    std::vector<Dependency> dependencies;
+    for (const TextureBakeReport& texture : TextureBaker::bakeTextures(*asset, sourcePath, {}, textureFormats, jobs)) {
+        Dependency dependency{texture.resolvedPath};
+        if (!dependency.path.empty() && hashFile(dependency.path, dependency.hash)) dependencies.push_back(dependency);
+    }
+    r.texturesMs = msSince(start);
+
+    start = Clock::now();
+    store(sourcePath, r.entryPath, *asset, dependencies);
+    r.storeMs = msSince(start);
+    return asset;
+}
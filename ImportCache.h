@@ -0,0 +1,58 @@
+#ifndef IMPORT_CACHE_H
+#define IMPORT_CACHE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "CharacterAsset.h"
+#include "FBXImporter.h"
+#include "JobSystem.h"
+
+struct ImportCacheReport {
+    bool hit = false;
+    std::string entryPath;
+    double hashMs = 0.0;     // source file and texture dependencies
+    double cacheReadMs = 0.0;
+    ImportTimings import;    // misses only
+    double texturesMs = 0.0; // misses only: texture decode and encode
+    double storeMs = 0.0;    // misses only
+};
+
+// On-disk cache of FBX imports for the editor. An entry is the freshly imported asset (raw clips,
+// embedded textures) with its textures already decoded to the requested formats, written as a
+// .character file named after the source's path and a hash of its contents and the import
+// settings; storing a new entry replaces the older one of the same source file only.
+// External texture files are recorded with their own hashes and rechecked on every hit; a texture
+// that was missing at import isn't tracked, so adding it later needs a Reimport.
+class ImportCache {
+public:
+    explicit ImportCache(std::string directory = ".import_cache", std::vector<std::string> textureFormats = {"rgba8"})
+        : directory(std::move(directory)), textureFormats(std::move(textureFormats)) {}
+
+    // Returns the cached import when the source and its textures are unchanged, otherwise imports,
+    // bakes textures and stores the result. reimport skips the lookup but still refreshes the
+    // entry. nullptr only if the import itself fails.
+    std::shared_ptr<CharacterAsset> load(const std::string& sourcePath, JobSystem* jobs = nullptr,
+                                         ImportCacheReport* report = nullptr, bool reimport = false) const;
+
+    // 64-bit content hash of a file, streamed in chunks; false if it can't be read
+    static bool hashFile(const std::string& path, uint64_t& hash);
+
+private:
+    struct Dependency {
+        std::string path;
+        uint64_t hash = 0;
+    };
+
+    uint64_t settingsHash() const;
+    std::string entryPrefix(const std::string& sourcePath) const;
+    bool dependenciesMatch(const std::string& depsPath) const;
+    void store(const std::string& sourcePath, const std::string& entryPath, const CharacterAsset& asset,
+               const std::vector<Dependency>& dependencies) const;
+
+    std::string directory;
+    std::vector<std::string> textureFormats;
+};
+
+#endif
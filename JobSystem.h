@@ -0,0 +1,166 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+// Emscripten builds without -pthread have no threads at all; everything runs on the caller
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define JOB_SYSTEM_THREADS 0
+#else
+#define JOB_SYSTEM_THREADS 1
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+// Small work-stealing thread pool for data-parallel loops. Each thread owns a task deque: it pops
+// its own work from the back and steals from the front of the others when it runs dry. The
+// thread calling parallelFor works on the batch too, so a pool of N threads spawns N - 1 workers.
+class JobSystem {
+public:
+    // threadCount includes the calling thread; 0 picks the hardware concurrency, 1 runs inline
+    explicit JobSystem(unsigned int threadCount = 0) {
+#if JOB_SYSTEM_THREADS
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+#else
+        threadCount = 1;
+#endif
+        for (unsigned int i = 0; i < threadCount; i++) queues.push_back(std::make_unique<Queue>());
+#if JOB_SYSTEM_THREADS
+        for (unsigned int i = 1; i < threadCount; i++) {
+            threads.emplace_back([this, i] { workerLoop(i); });
+        }
+#endif
+    }
+
+    ~JobSystem() {
+#if JOB_SYSTEM_THREADS
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+#endif
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int getThreadCount() const { return (unsigned int)queues.size(); }
+
+    // Calls fn(begin, end) over [0, count) in chunks of at most grainSize and blocks until all
+    // chunks are done. Chunk boundaries depend only on count and grainSize, never on timing.
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grainSize, Fn&& fn) {
+        if (count == 0) return;
+        grainSize = std::max<size_t>(grainSize, 1);
+#if JOB_SYSTEM_THREADS
+        if (queues.size() > 1 && count > grainSize) {
+            using FnType = std::remove_reference_t<Fn>;
+            size_t chunks = (count + grainSize - 1) / grainSize;
+            std::atomic<size_t> pending(chunks);
+            Task task;
+            task.run = [](void* context, size_t begin, size_t end) { (*static_cast<FnType*>(context))(begin, end); };
+            task.context = (void*)&fn;
+            task.pending = &pending;
+            for (size_t c = 0; c < chunks; c++) {
+                task.begin = c * grainSize;
+                task.end = std::min(count, task.begin + grainSize);
+                Queue& queue = *queues[c % queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(task);
+            }
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                queuedTasks += chunks;
+            }
+            wake.notify_all();
+
+            // Help out until the whole batch is finished
+            while (pending.load(std::memory_order_acquire) > 0) {
+                if (!runOneTask(0)) std::this_thread::yield();
+            }
+            return;
+        }
+#endif
+        for (size_t begin = 0; begin < count; begin += grainSize) {
+            fn(begin, std::min(count, begin + grainSize));
+        }
+    }
+
+private:
+    struct Task {
+        void (*run)(void* context, size_t begin, size_t end) = nullptr;
+        void* context = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        std::atomic<size_t>* pending = nullptr;
+    };
+
+    struct Queue {
+#if JOB_SYSTEM_THREADS
+        std::mutex mutex;
+#endif
+        std::deque<Task> tasks;
+    };
+
+#if JOB_SYSTEM_THREADS
+    bool popOwn(unsigned int index, Task& task) {
+        Queue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned int thief, Task& task) {
+        for (size_t n = 1; n < queues.size(); n++) {
+            Queue& queue = *queues[(thief + n) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool runOneTask(unsigned int index) {
+        Task task;
+        if (!popOwn(index, task) && !steal(index, task)) return false;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            queuedTasks--;
+        }
+        task.run(task.context, task.begin, task.end);
+        task.pending->fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    void workerLoop(unsigned int index) {
+        for (;;) {
+            if (runOneTask(index)) continue;
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [this] { return stopping || queuedTasks > 0; });
+            if (stopping) return;
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    size_t queuedTasks = 0;
+    bool stopping = false;
+#endif
+    std::vector<std::unique_ptr<Queue>> queues;
+};
+
+#endif
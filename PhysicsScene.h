@@ -0,0 +1,435 @@
+#ifndef PHYSICS_SCENE_H
+#define PHYSICS_SCENE_H
+
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "CharacterPhysics.h"
+#include "JobSystem.h"
+
+// Ray queries across every character of a world. update() boxes each character's animated
+// colliders and keeps the boxes in a dynamic AABB tree: leaves are fattened so most ticks leave
+// them alone, and a leaf whose character moves out of it is reinserted where it adds the least
+// surface area, with rotations keeping the tree balanced. Rays walk the tree front to back and
+// only test the capsules of characters whose boxes they reach before the closest hit so far.
+//
+// Queries may run concurrently with each other, not with add(), remove() or update().
+class PhysicsScene {
+public:
+    struct Hit {
+        int body = -1;
+        HitResult hit;
+    };
+
+    struct Stats {
+        uint64_t rays = 0;
+        uint64_t nodesVisited = 0;
+        uint64_t bodiesTested = 0;  // narrowphase capsule batches run
+        uint64_t reinserts = 0;     // leaves update() had to move
+    };
+
+    // Leaves are fattened by margin times their largest extent on every side
+    explicit PhysicsScene(float margin = 0.1f) : margin(margin) {}
+
+    PhysicsScene(const PhysicsScene&) = delete;
+    PhysicsScene& operator=(const PhysicsScene&) = delete;
+
+    // Ids are handed out in order and reused after remove(). The body joins the tree at the next
+    // update(); physics must outlive it.
+    int add(const CharacterPhysics& physics) {
+        int id;
+        if (!freeBodies.empty()) {
+            id = freeBodies.back();
+            freeBodies.pop_back();
+        } else {
+            id = (int)bodies.size();
+            bodies.emplace_back();
+        }
+        bodies[id] = Body();
+        bodies[id].physics = &physics;
+        return id;
+    }
+
+    void remove(int id) {
+        Body& body = bodies[id];
+        if (body.leaf >= 0) {
+            removeLeaf(body.leaf);
+            freeNode(body.leaf);
+        }
+        body = Body();
+        freeBodies.push_back(id);
+    }
+
+    // Call after the characters' CharacterPhysics::update. jobs, if given, computes the boxes on
+    // its threads; the tree itself is refit on the calling thread.
+    void update(JobSystem* jobs = nullptr) {
+        auto computeBounds = [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                Body& body = bodies[i];
+                body.valid = body.physics && body.physics->bounds(body.bounds.low, body.bounds.high);
+            }
+        };
+        if (jobs) jobs->parallelFor(bodies.size(), 256, computeBounds);
+        else computeBounds(0, bodies.size());
+
+        for (size_t i = 0; i < bodies.size(); i++) {
+            Body& body = bodies[i];
+            if (body.leaf >= 0 && body.valid && contains(nodes[body.leaf].box, body.bounds)) continue;
+            if (body.leaf >= 0) {
+                removeLeaf(body.leaf);
+                freeNode(body.leaf);
+                body.leaf = -1;
+            }
+            if (!body.valid) continue;
+            int leaf = allocateNode();
+            nodes[leaf].box = fatten(body.bounds);
+            nodes[leaf].body = (int)i;
+            insertLeaf(leaf);
+            body.leaf = leaf;
+            reinserts++;
+        }
+    }
+
+    // Closest hit with distance < ray.maxDistance over every body
+    bool raycast(const Ray& ray, Hit& hit) const {
+        TraversalStack stack;
+        QueryCounters counters;
+        bool found = traverse(ray, hit, stack, counters);
+        addCounters(counters, 1);
+        return found;
+    }
+
+    // Closest hit of every ray; hits[i].body is -1 for a miss. Returns how many rays hit. jobs, if
+    // given, splits the rays over its threads.
+    size_t raycastBatch(const Ray* rays, size_t count, Hit* hits, JobSystem* jobs = nullptr) const {
+        auto run = [&](size_t begin, size_t end) {
+            TraversalStack stack;
+            QueryCounters counters;
+            for (size_t i = begin; i < end; i++) {
+                if (!traverse(rays[i], hits[i], stack, counters)) hits[i] = Hit();
+            }
+            addCounters(counters, end - begin);
+        };
+        if (jobs) jobs->parallelFor(count, 64, run);
+        else run(0, count);
+
+        size_t hitCount = 0;
+        for (size_t i = 0; i < count; i++) hitCount += hits[i].body >= 0;
+        return hitCount;
+    }
+
+    Stats getStats() const {
+        Stats stats;
+        stats.rays = rays.load();
+        stats.nodesVisited = nodesVisited.load();
+        stats.bodiesTested = bodiesTested.load();
+        stats.reinserts = reinserts;
+        return stats;
+    }
+
+    void resetStats() {
+        rays = 0;
+        nodesVisited = 0;
+        bodiesTested = 0;
+        reinserts = 0;
+    }
+
+    // 0 for an empty tree or a single leaf
+    int treeHeight() const { return root < 0 ? 0 : nodes[root].height; }
+
+private:
+    struct Box {
+        glm::vec3 low;
+        glm::vec3 high;
+    };
+
+    // Leaves have no children and a body; freed nodes chain through parent
+    struct Node {
+        Box box;
+        int parent = -1;
+        int left = -1;
+        int right = -1;
+        int height = 0;
+        int body = -1;
+    };
+
+    struct Body {
+        const CharacterPhysics* physics = nullptr;
+        Box bounds;
+        bool valid = false;
+        int leaf = -1;
+    };
+
+    struct StackEntry {
+        int node;
+        float entry;
+    };
+
+    // Walking the tree keeps at most one pending sibling per level, so a balanced tree never
+    // needs more than its height + 1 entries; the vector only backs a tree deeper than kFixed.
+    struct TraversalStack {
+        static constexpr int kFixed = 64;
+        StackEntry fixed[kFixed];
+        std::vector<StackEntry> spill;
+        int size = 0;
+
+        bool empty() const { return size == 0; }
+        void clear() {
+            size = 0;
+            spill.clear();
+        }
+        void push(const StackEntry& entry) {
+            if (size < kFixed) fixed[size] = entry;
+            else spill.push_back(entry);
+            size++;
+        }
+        StackEntry pop() {
+            size--;
+            if (size < kFixed) return fixed[size];
+            StackEntry entry = spill.back();
+            spill.pop_back();
+            return entry;
+        }
+    };
+
+    struct QueryCounters {
+        uint64_t nodesVisited = 0;
+        uint64_t bodiesTested = 0;
+    };
+
+    static Box merge(const Box& a, const Box& b) { return {glm::min(a.low, b.low), glm::max(a.high, b.high)}; }
+
+    static float area(const Box& box) {
+        glm::vec3 d = box.high - box.low;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    static bool contains(const Box& outer, const Box& inner) {
+        return outer.low.x <= inner.low.x && outer.low.y <= inner.low.y && outer.low.z <= inner.low.z &&
+               outer.high.x >= inner.high.x && outer.high.y >= inner.high.y && outer.high.z >= inner.high.z;
+    }
+
+    Box fatten(const Box& box) const {
+        glm::vec3 d = box.high - box.low;
+        glm::vec3 pad(margin * std::max(d.x, std::max(d.y, d.z)));
+        return {box.low - pad, box.high + pad};
+    }
+
+    // Parameter at which the ray enters the box, clipped to [0, maxT]; false if it misses
+    static bool enter(const Box& box, const glm::vec3& origin, const glm::vec3& inverseDir, float maxT, float& entry) {
+        float tMin = 0.0f, tMax = maxT;
+        for (int axis = 0; axis < 3; axis++) {
+            float t0 = (box.low[axis] - origin[axis]) * inverseDir[axis];
+            float t1 = (box.high[axis] - origin[axis]) * inverseDir[axis];
+            if (t0 > t1) std::swap(t0, t1);
+            // NaN (a zero direction on the box's boundary plane) leaves the interval as it was
+            tMin = t0 > tMin ? t0 : tMin;
+            tMax = t1 < tMax ? t1 : tMax;
+            if (tMin > tMax) return false;
+        }
+        entry = tMin;
+        return true;
+    }
+
+    bool traverse(const Ray& ray, Hit& hit, TraversalStack& stack, QueryCounters& counters) const {
+        if (root < 0) return false;
+        glm::vec3 inverseDir = 1.0f / ray.direction;
+        float best = ray.maxDistance;
+        bool found = false;
+        float entry;
+        stack.clear();
+        if (enter(nodes[root].box, ray.origin, inverseDir, best, entry)) stack.push({root, entry});
+
+        while (!stack.empty()) {
+            StackEntry top = stack.pop();
+            // A node entered past the closest hit so far can't hold a closer one
+            if (top.entry >= best) continue;
+            counters.nodesVisited++;
+            const Node& node = nodes[top.node];
+            if (node.left < 0) {
+                counters.bodiesTested++;
+                Ray clipped = ray;
+                clipped.maxDistance = best;
+                if (bodies[node.body].physics->raycast(clipped, hit.hit)) {
+                    best = hit.hit.distance;
+                    hit.body = node.body;
+                    found = true;
+                }
+                continue;
+            }
+            // Push the farther child first so the nearer one is walked first
+            float leftEntry, rightEntry;
+            bool leftHit = enter(nodes[node.left].box, ray.origin, inverseDir, best, leftEntry);
+            bool rightHit = enter(nodes[node.right].box, ray.origin, inverseDir, best, rightEntry);
+            if (leftHit && rightHit) {
+                bool leftFirst = leftEntry <= rightEntry;
+                stack.push(leftFirst ? StackEntry{node.right, rightEntry} : StackEntry{node.left, leftEntry});
+                stack.push(leftFirst ? StackEntry{node.left, leftEntry} : StackEntry{node.right, rightEntry});
+            } else if (leftHit) {
+                stack.push({node.left, leftEntry});
+            } else if (rightHit) {
+                stack.push({node.right, rightEntry});
+            }
+        }
+        return found;
+    }
+
+    void addCounters(const QueryCounters& counters, size_t rayCount) const {
+        rays += rayCount;
+        nodesVisited += counters.nodesVisited;
+        bodiesTested += counters.bodiesTested;
+    }
+
+    int allocateNode() {
+        if (freeNodes < 0) {
+            nodes.emplace_back();
+            return (int)nodes.size() - 1;
+        }
+        int index = freeNodes;
+        freeNodes = nodes[index].parent;
+        nodes[index] = Node();
+        return index;
+    }
+
+    void freeNode(int index) {
+        nodes[index] = Node();
+        nodes[index].parent = freeNodes;
+        freeNodes = index;
+    }
+
+    // Walks down to the sibling that grows the tree's total surface area the least
+    void insertLeaf(int leaf) {
+        if (root < 0) {
+            root = leaf;
+            nodes[leaf].parent = -1;
+            return;
+        }
+        Box leafBox = nodes[leaf].box;
+        int index = root;
+        while (nodes[index].left >= 0) {
+            const Node& node = nodes[index];
+            float nodeArea = area(node.box);
+            float combinedArea = area(merge(node.box, leafBox));
+            // Cost of pairing with this node here, and what descending adds to every ancestor
+            float cost = 2.0f * combinedArea;
+            float inheritance = 2.0f * (combinedArea - nodeArea);
+            auto descendCost = [&](int child) {
+                float merged = area(merge(leafBox, nodes[child].box));
+                return (nodes[child].left < 0 ? merged : merged - area(nodes[child].box)) + inheritance;
+            };
+            float leftCost = descendCost(node.left);
+            float rightCost = descendCost(node.right);
+            if (cost < leftCost && cost < rightCost) break;
+            index = leftCost < rightCost ? node.left : node.right;
+        }
+
+        int sibling = index;
+        int oldParent = nodes[sibling].parent;
+        int newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = merge(leafBox, nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].left = sibling;
+        nodes[newParent].right = leaf;
+        if (oldParent >= 0) {
+            if (nodes[oldParent].left == sibling) nodes[oldParent].left = newParent;
+            else nodes[oldParent].right = newParent;
+        } else {
+            root = newParent;
+        }
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+        refit(newParent);
+    }
+
+    void removeLeaf(int leaf) {
+        if (leaf == root) {
+            root = -1;
+            return;
+        }
+        int parent = nodes[leaf].parent;
+        int grandParent = nodes[parent].parent;
+        int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+        if (grandParent >= 0) {
+            if (nodes[grandParent].left == parent) nodes[grandParent].left = sibling;
+            else nodes[grandParent].right = sibling;
+            nodes[sibling].parent = grandParent;
+            freeNode(parent);
+            refit(grandParent);
+        } else {
+            root = sibling;
+            nodes[sibling].parent = -1;
+            freeNode(parent);
+        }
+        nodes[leaf].parent = -1;
+    }
+
+    // Rebalances and recomputes boxes and heights from index up to the root
+    void refit(int index) {
+        while (index >= 0) {
+            index = balance(index);
+            Node& node = nodes[index];
+            node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+            node.box = merge(nodes[node.left].box, nodes[node.right].box);
+            index = node.parent;
+        }
+    }
+
+    // Rotates the taller grandchild up when a's subtrees differ in height by more than one;
+    // returns the node now at a's place
+    int balance(int a) {
+        if (nodes[a].left < 0 || nodes[a].height < 2) return a;
+        int b = nodes[a].left;
+        int c = nodes[a].right;
+        int difference = nodes[c].height - nodes[b].height;
+        if (difference > 1) return rotateUp(a, c, b, false);
+        if (difference < -1) return rotateUp(a, b, c, true);
+        return a;
+    }
+
+    // Moves child up to a's place; a keeps other and takes child's shorter subtree
+    int rotateUp(int a, int child, int other, bool childIsLeft) {
+        int f = nodes[child].left;
+        int g = nodes[child].right;
+        nodes[child].left = a;
+        nodes[child].parent = nodes[a].parent;
+        nodes[a].parent = child;
+        int parent = nodes[child].parent;
+        if (parent >= 0) {
+            if (nodes[parent].left == a) nodes[parent].left = child;
+            else nodes[parent].right = child;
+        } else {
+            root = child;
+        }
+
+        int taller = nodes[f].height > nodes[g].height ? f : g;
+        int shorter = taller == f ? g : f;
+        nodes[child].right = taller;
+        if (childIsLeft) nodes[a].left = shorter;
+        else nodes[a].right = shorter;
+        nodes[shorter].parent = a;
+
+        nodes[a].box = merge(nodes[other].box, nodes[shorter].box);
+        nodes[a].height = 1 + std::max(nodes[other].height, nodes[shorter].height);
+        nodes[child].box = merge(nodes[a].box, nodes[taller].box);
+        nodes[child].height = 1 + std::max(nodes[a].height, nodes[taller].height);
+        return child;
+    }
+
+    float margin;
+    std::vector<Node> nodes;
+    int root = -1;
+    int freeNodes = -1;
+    std::vector<Body> bodies;
+    std::vector<int> freeBodies;
+    uint64_t reinserts = 0;
+    mutable std::atomic<uint64_t> rays{0};
+    mutable std::atomic<uint64_t> nodesVisited{0};
+    mutable std::atomic<uint64_t> bodiesTested{0};
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Instruction set is picked at compile time: AVX2/FMA or SSE on x86 (SSE2 is baseline on x86-64),
+// SIMD128 on WebAssembly built with -msimd128, plain scalar code anywhere else.
+#if defined(__AVX2__) && defined(__FMA__)
+#define SIMD_MATH_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define SIMD_MATH_SSE 1
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#define SIMD_MATH_WASM 1
+#include <wasm_simd128.h>
+#else
+#define SIMD_MATH_SCALAR 1
+#endif
+
+// Matrix kernels for the skeleton hot loop. Matrices are glm's column-major layout and may be
+// unaligned; outputs may alias inputs.
+class SimdMath {
+public:
+    static const char* instructionSet() {
+#if SIMD_MATH_AVX2
+        return "AVX2+FMA";
+#elif SIMD_MATH_SSE
+        return "SSE2";
+#elif SIMD_MATH_WASM
+        return "WASM SIMD128";
+#else
+        return "scalar";
+#endif
+    }
+
+    // out = translate(t) * mat4_cast(r) * scale(s), written directly from the quaternion terms
+    // instead of multiplying three matrices. r must be normalized.
+    static void composeAffine(const glm::vec3& t, const glm::quat& r, const glm::vec3& s, glm::mat4& out) {
+        float x2 = r.x + r.x, y2 = r.y + r.y, z2 = r.z + r.z;
+        float xx = r.x * x2, yy = r.y * y2, zz = r.z * z2;
+        float xy = r.x * y2, xz = r.x * z2, yz = r.y * z2;
+        float wx = r.w * x2, wy = r.w * y2, wz = r.w * z2;
+        out[0] = glm::vec4((1.0f - (yy + zz)) * s.x, (xy + wz) * s.x, (xz - wy) * s.x, 0.0f);
+        out[1] = glm::vec4((xy - wz) * s.y, (1.0f - (xx + zz)) * s.y, (yz + wx) * s.y, 0.0f);
+        out[2] = glm::vec4((xz + wy) * s.z, (yz - wx) * s.z, (1.0f - (xx + yy)) * s.z, 0.0f);
+        out[3] = glm::vec4(t, 1.0f);
+    }
+
+    // out = a * b
+    static void mul(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+        const float* pa = &a[0][0];
+        const float* pb = &b[0][0];
+        float* po = &out[0][0];
+#if SIMD_MATH_AVX2
+        // Two result columns per iteration: each 256-bit register holds a pair of columns
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)(pa + 0));
+        __m256 a1 = _mm256_broadcast_ps((const __m128*)(pa + 4));
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)(pa + 8));
+        __m256 a3 = _mm256_broadcast_ps((const __m128*)(pa + 12));
+        __m256 b01 = _mm256_loadu_ps(pb);
+        __m256 b23 = _mm256_loadu_ps(pb + 8);
+        __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+        __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+        r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+        r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+        r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+        r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+        r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+        r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+        _mm256_storeu_ps(po, r01);
+        _mm256_storeu_ps(po + 8, r23);
+#elif SIMD_MATH_SSE
+        __m128 a0 = _mm_loadu_ps(pa + 0);
+        __m128 a1 = _mm_loadu_ps(pa + 4);
+        __m128 a2 = _mm_loadu_ps(pa + 8);
+        __m128 a3 = _mm_loadu_ps(pa + 12);
+        __m128 r[4];
+        for (int c = 0; c < 4; c++) {
+            __m128 bc = _mm_loadu_ps(pb + c * 4);
+            __m128 v = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)));
+            v = _mm_add_ps(v, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+            v = _mm_add_ps(v, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+            v = _mm_add_ps(v, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+            r[c] = v;
+        }
+        for (int c = 0; c < 4; c++) _mm_storeu_ps(po + c * 4, r[c]);
+#elif SIMD_MATH_WASM
+        v128_t a0 = wasm_v128_load(pa + 0);
+        v128_t a1 = wasm_v128_load(pa + 4);
+        v128_t a2 = wasm_v128_load(pa + 8);
+        v128_t a3 = wasm_v128_load(pa + 12);
+        v128_t r[4];
+        for (int c = 0; c < 4; c++) {
+            v128_t bc = wasm_v128_load(pb + c * 4);
+            v128_t v = wasm_f32x4_mul(a0, wasm_i32x4_shuffle(bc, bc, 0, 0, 0, 0));
+            v = wasm_f32x4_add(v, wasm_f32x4_mul(a1, wasm_i32x4_shuffle(bc, bc, 1, 1, 1, 1)));
+            v = wasm_f32x4_add(v, wasm_f32x4_mul(a2, wasm_i32x4_shuffle(bc, bc, 2, 2, 2, 2)));
+            v = wasm_f32x4_add(v, wasm_f32x4_mul(a3, wasm_i32x4_shuffle(bc, bc, 3, 3, 3, 3)));
+            r[c] = v;
+        }
+        for (int c = 0; c < 4; c++) wasm_v128_store(po + c * 4, r[c]);
+#else
+        out = a * b;
+#endif
+    }
+
+    // out[i] = a[i] + (b[i] - a[i]) * t over count matrices, component-wise
+    static void lerp(const glm::mat4* a, const glm::mat4* b, float t, glm::mat4* out, size_t count) {
+        const float* pa = &a[0][0][0];
+        const float* pb = &b[0][0][0];
+        float* po = &out[0][0][0];
+        size_t n = count * 16;
+        size_t i = 0;
+#if SIMD_MATH_AVX2
+        __m256 vt = _mm256_set1_ps(t);
+        for (; i + 8 <= n; i += 8) {
+            __m256 va = _mm256_loadu_ps(pa + i);
+            _mm256_storeu_ps(po + i, _mm256_fmadd_ps(_mm256_sub_ps(_mm256_loadu_ps(pb + i), va), vt, va));
+        }
+#elif SIMD_MATH_SSE
+        __m128 vt = _mm_set1_ps(t);
+        for (; i + 4 <= n; i += 4) {
+            __m128 va = _mm_loadu_ps(pa + i);
+            _mm_storeu_ps(po + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pb + i), va), vt)));
+        }
+#elif SIMD_MATH_WASM
+        v128_t vt = wasm_f32x4_splat(t);
+        for (; i + 4 <= n; i += 4) {
+            v128_t va = wasm_v128_load(pa + i);
+            wasm_v128_store(po + i, wasm_f32x4_add(va, wasm_f32x4_mul(wasm_f32x4_sub(wasm_v128_load(pb + i), va), vt)));
+        }
+#endif
+        for (; i < n; i++) po[i] = pa[i] + (pb[i] - pa[i]) * t;
+    }
+};
+
+#endif
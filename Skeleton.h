@@ -0,0 +1,113 @@
+#ifndef SKELETON_H
+#define SKELETON_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "SimdMath.h"
+
+// Local bone pose as translation/rotation/scale, the space animation is sampled and blended in.
+struct BoneTransform {
+    glm::vec3 translation = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+
+    // Equivalent to translate * rotate * scale
+    glm::mat4 toMatrix() const {
+        glm::mat4 m;
+        SimdMath::composeAffine(translation, rotation, scale, m);
+        return m;
+    }
+};
+
+// Bind-pose skeleton flattened in depth-first order, so a bone's parent always comes before it.
+// Per-bone data lives in parallel arrays; the hot path only touches parentIndices and the matrices.
+struct Skeleton {
+    std::vector<int> parentIndices;
+    std::vector<BoneTransform> bindPose;
+    std::vector<glm::mat4> offsetMatrices;
+    glm::mat4 globalInverseTransform = glm::mat4(1.0f);
+
+    // Only needed by tools (names, hierarchy display)
+    std::vector<std::string> names;
+    std::vector<std::vector<int>> children;
+
+    size_t size() const { return parentIndices.size(); }
+
+    int addBone(const std::string& name, int parentIndex, const BoneTransform& bindLocal) {
+        int index = (int)parentIndices.size();
+        parentIndices.push_back(parentIndex);
+        bindPose.push_back(bindLocal);
+        offsetMatrices.push_back(glm::mat4(1.0f));
+        names.push_back(name);
+        children.emplace_back();
+        if (parentIndex != -1) children[parentIndex].push_back(index);
+        return index;
+    }
+
+    // Local-to-world and skinning palette in one linear pass over the bones.
+    void evaluate(const BoneTransform* localPoses, glm::mat4* worldTransforms, glm::mat4* palette) const {
+        const size_t count = size();
+        glm::mat4 local, globalWorld;
+        for (size_t i = 0; i < count; i++) {
+            int parent = parentIndices[i];
+            const BoneTransform& pose = localPoses[i];
+            if (parent < 0) {
+                SimdMath::composeAffine(pose.translation, pose.rotation, pose.scale, worldTransforms[i]);
+            } else {
+                SimdMath::composeAffine(pose.translation, pose.rotation, pose.scale, local);
+                SimdMath::mul(worldTransforms[parent], local, worldTransforms[i]);
+            }
+            SimdMath::mul(globalInverseTransform, worldTransforms[i], globalWorld);
+            SimdMath::mul(globalWorld, offsetMatrices[i], palette[i]);
+        }
+    }
+};
+
+// Read-only view of one bone, gathered from the skeleton and the current pose arrays.
+struct Bone {
+    const std::string& name;
+    int parentIndex;
+    const std::vector<int>& children;
+    const glm::mat4& offsetMatrix;
+    const glm::mat4& worldTransform;
+    const glm::mat4& finalTransform;
+};
+
+// Indexable, iterable list of Bone views over a skeleton and its evaluated pose.
+class BoneList {
+public:
+    BoneList(const Skeleton& skeleton, const glm::mat4* worldTransforms, const glm::mat4* palette) :
+        skeleton(&skeleton), worldTransforms(worldTransforms), palette(palette) {}
+
+    Bone operator[](size_t i) const {
+        return {skeleton->names[i], skeleton->parentIndices[i], skeleton->children[i],
+                skeleton->offsetMatrices[i], worldTransforms[i], palette[i]};
+    }
+    size_t size() const { return skeleton->size(); }
+    bool empty() const { return skeleton->size() == 0; }
+    // Skinning matrices of every bone, for indexed access without the name lookups
+    const glm::mat4* getPalette() const { return palette; }
+
+    class iterator {
+    public:
+        iterator(const BoneList* list, size_t index) : list(list), index(index) {}
+        Bone operator*() const { return (*list)[index]; }
+        iterator& operator++() { ++index; return *this; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+    private:
+        const BoneList* list;
+        size_t index;
+    };
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+
+private:
+    const Skeleton* skeleton;
+    const glm::mat4* worldTransforms;
+    const glm::mat4* palette;
+};
+
+#endif
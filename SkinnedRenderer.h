@@ -5,11 +5,13 @@
 #include <string>
 #include <iostream>
 #include <map>
+#include <span>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "FBXStateMachine.h"
-#include "stb_image.h"
+#include "TextureUpload.h"
+#include "AssetDatabase.h"
 
 #ifdef __EMSCRIPTEN__
 #include <GLES3/gl3.h>
@@ -22,10 +24,31 @@ public:
     struct MeshGL {
         GLuint vao, vbo, ebo;
         GLsizei count;
+        GLenum indexType = GL_UNSIGNED_INT;
+        glm::vec4 uvTransform = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);  // offset, scale
         GLuint textureID = 0;
+        AssetDatabase::TextureHandle texture;  // keeps textureID resident
+        std::string texturePath;
     };
 
-    void init(const std::vector<FBXStateMachine::MeshData>& meshes) {
+    // Meshes of the asset at path and the textures baked for them, shared with every other
+    // renderer of that asset through the database. The database needs a texture backend
+    // (TextureUpload::databaseBackend); mesh textures that weren't baked render untextured.
+    void init(AssetDatabase& database, const std::string& path) {
+        AssetDatabase::CharacterHandle asset = database.character(path);
+        if (!asset) return;
+        initProgram();
+        setMeshes(asset->getMeshes());
+        for (MeshGL& m : meshGLs) {
+            if (m.texturePath.empty()) continue;
+            m.texture = database.texture(path, m.texturePath);
+            if (m.texture) m.textureID = m.texture->id;
+            else std::cerr << "Texture was not baked: " << m.texturePath << std::endl;
+        }
+    }
+
+    // Shaders and the bone buffer, without any meshes yet (streaming fills them in later)
+    void initProgram() {
 #ifdef __EMSCRIPTEN__
         const char* glslVersion = "#version 300 es";
 #else
@@ -35,23 +58,24 @@ public:
         vShaderSrc += R"(
             layout(std140) uniform BoneMatrices { mat4 u_bones[256]; };
             uniform mat4 u_vp;
+            uniform vec4 u_uvTransform;
             layout(location=0) in vec3 a_pos;
             layout(location=1) in vec2 a_uv;
-            layout(location=2) in ivec4 a_boneIds;
+            layout(location=2) in uvec4 a_boneIds;
             layout(location=3) in vec4 a_weights;
             out vec2 v_uv;
             void main() {
                 vec4 pos = vec4(0.0);
                 float totalWeight = 0.0;
                 for(int i=0; i<4; i++) {
-                    if(a_boneIds[i] >= 0 && a_boneIds[i] < 256) {
+                    if(a_boneIds[i] < 256u) {
                         pos += a_weights[i] * (u_bones[a_boneIds[i]] * vec4(a_pos, 1.0));
                         totalWeight += a_weights[i];
                     }
                 }
                 if (totalWeight < 0.01) pos = vec4(a_pos, 1.0);
                 gl_Position = u_vp * vec4(pos.xyz, 1.0);
-                v_uv = a_uv;
+                v_uv = u_uvTransform.xy + u_uvTransform.zw * a_uv;
             }
         )";
 
@@ -81,18 +105,17 @@ public:
         GLuint blockIdx = glGetUniformBlockIndex(program, "BoneMatrices");
         if (blockIdx != GL_INVALID_INDEX) glUniformBlockBinding(program, blockIdx, 0);
         glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboBones);
+    }
 
+    // Replaces the drawn meshes. Textures set by name are kept and applied to the new meshes.
+    void setMeshes(const std::vector<FBXStateMachine::MeshData>& meshes) {
+        clearMeshes();
         std::cout << "Initializing renderer with " << meshes.size() << " meshes." << std::endl;
         for (const auto& mData : meshes) {
             MeshGL m;
-            m.textureID = 0;
-            if (!mData.texturePath.empty()) {
-                if (textureCache.find(mData.texturePath) == textureCache.end()) {
-                    GLuint texID = loadTexture(mData.texturePath);
-                    if (texID != 0) textureCache[mData.texturePath] = texID;
-                }
-                if (textureCache.count(mData.texturePath)) m.textureID = textureCache[mData.texturePath];
-            }
+            m.texturePath = mData.texturePath;
+            auto named = namedTextures.find(mData.texturePath);
+            m.textureID = named != namedTextures.end() ? named->second : 0;
 
             glGenVertexArrays(1, &m.vao);
             glGenBuffers(1, &m.vbo);
@@ -103,28 +126,50 @@ public:
             glBufferData(GL_ARRAY_BUFFER, mData.vertices.size() * sizeof(FBXStateMachine::Vertex), mData.vertices.data(), GL_STATIC_DRAW);
 
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.ebo);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mData.indices.size() * sizeof(unsigned int), mData.indices.data(), GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mData.indices.size() * mData.indices.elementSize(), mData.indices.data(), GL_STATIC_DRAW);
 
             glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, position));
             glEnableVertexAttribArray(0);
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, uv));
+            glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, uv));
             glEnableVertexAttribArray(1);
-            glVertexAttribIPointer(2, 4, GL_INT, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, boneIds));
+            glVertexAttribIPointer(2, 4, GL_UNSIGNED_BYTE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, boneIds));
             glEnableVertexAttribArray(2);
-            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, weights));
+            glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(FBXStateMachine::Vertex), (void*)offsetof(FBXStateMachine::Vertex, weights));
             glEnableVertexAttribArray(3);
 
             m.count = (GLsizei)mData.indices.size();
+            m.indexType = mData.indices.isShort() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            m.uvTransform = glm::vec4(mData.uvOffset, mData.uvScale);
             meshGLs.push_back(m);
         }
         glBindVertexArray(0);
     }
 
-    void render(const std::vector<glm::mat4>& bones) {
+    // Binds a texture to every mesh (current and later) referencing it by path; 0 unbinds it.
+    // The caller keeps ownership of the GL texture.
+    void setTexture(const std::string& path, GLuint textureID) {
+        namedTextures[path] = textureID;
+        for (MeshGL& m : meshGLs) {
+            if (m.texturePath == path) m.textureID = textureID;
+        }
+    }
+
+    void clearMeshes() {
+        for (MeshGL& m : meshGLs) {
+            glDeleteVertexArrays(1, &m.vao);
+            glDeleteBuffers(1, &m.vbo);
+            glDeleteBuffers(1, &m.ebo);
+        }
+        meshGLs.clear();
+    }
+
+    const glm::vec3& getCameraPosition() const { return cameraPosition; }
+
+    void render(std::span<const glm::mat4> bones) {
         glUseProgram(program);
         
         // Setup simple camera
-        glm::mat4 view = glm::lookAt(glm::vec3(0, 100, 300), glm::vec3(0, 100, 0), glm::vec3(0, 1, 0));
+        glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(0, 100, 0), glm::vec3(0, 1, 0));
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1280.0f/720.0f, 0.1f, 10000.0f);
         glm::mat4 vp = projection * view;
         glUniformMatrix4fv(glGetUniformLocation(program, "u_vp"), 1, GL_FALSE, glm::value_ptr(vp));
@@ -143,8 +188,9 @@ public:
             } else {
                 glUniform1i(glGetUniformLocation(program, "u_hasTexture"), 0);
             }
+            glUniform4fv(glGetUniformLocation(program, "u_uvTransform"), 1, glm::value_ptr(m.uvTransform));
             glBindVertexArray(m.vao);
-            glDrawElements(GL_TRIANGLES, m.count, GL_UNSIGNED_INT, 0);
+            glDrawElements(GL_TRIANGLES, m.count, m.indexType, 0);
         }
         glBindVertexArray(0);
     }
@@ -189,58 +235,11 @@ private:
         }
     }
 
-    GLuint loadTexture(const std::string& path) {
-        if (path.empty()) return 0;
-        
-        int w, h, ch;
-        stbi_set_flip_vertically_on_load(true);
-        
-        std::vector<std::string> pathsToTry;
-        pathsToTry.push_back(path);
-        
-        // Extract filename
-        size_t lastSlash = path.find_last_of("/\\");
-        std::string filename = (lastSlash == std::string::npos) ? path : path.substr(lastSlash + 1);
-        std::string dir = (lastSlash == std::string::npos) ? "" : path.substr(0, lastSlash + 1);
-        
-        if (lastSlash != std::string::npos) {
-            pathsToTry.push_back(filename); // Try current dir
-            pathsToTry.push_back(dir + "textures/" + filename);
-            pathsToTry.push_back(dir + "Textures/" + filename);
-        } else {
-            pathsToTry.push_back("textures/" + filename);
-            pathsToTry.push_back("Textures/" + filename);
-        }
-
-        unsigned char* data = nullptr;
-        for (const auto& tryPath : pathsToTry) {
-            data = stbi_load(tryPath.c_str(), &w, &h, &ch, 0);
-            if (data) break;
-        }
-
-        if (!data) {
-            std::cerr << "Texture failed to load from all paths: " << path << std::endl;
-            return 0;
-        }
-
-        GLuint tex;
-        glGenTextures(1, &tex);
-        glBindTexture(GL_TEXTURE_2D, tex);
-        GLenum fmt = (ch == 4) ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, fmt, w, h, 0, fmt, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        stbi_image_free(data);
-        return tex;
-    }
-
     GLuint uboBones;
     GLuint program;
+    glm::vec3 cameraPosition = glm::vec3(0, 100, 300);
     std::vector<MeshGL> meshGLs;
-    std::map<std::string, GLuint> textureCache;
+    std::map<std::string, GLuint> namedTextures;
 };
 
 #endif
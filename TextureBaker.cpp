@@ -0,0 +1,239 @@
+#include "TextureBaker.h"
+#include <iostream>
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include "TextureCompression.h"
+#include "stb_image.h"
+
+// GL wants the bottom row first
+static void flipRows(CharacterAsset::TextureLevel& image) {
+    size_t stride = (size_t)image.width * 4;
+    for (int y = 0; y < image.height / 2; y++) {
+        std::swap_ranges(image.data.begin() + y * stride, image.data.begin() + (y + 1) * stride,
+                         image.data.begin() + (image.height - 1 - y) * stride);
+    }
+}
+
+static std::string directoryOf(const std::string& path) {
+    size_t lastSlash = path.find_last_of("/\\");
+    return lastSlash == std::string::npos ? "" : path.substr(0, lastSlash + 1);
+}
+
+std::vector<std::string> TextureBaker::candidatePaths(const std::string& path, const std::string& sourcePath,
+                                                      const std::vector<std::string>& searchDirectories) {
+    std::string dir = directoryOf(path);
+    std::string filename = path.substr(dir.size());
+
+    // Exporters put embedded media in a "<name>.fbm" folder next to the FBX
+    std::string sourceBase = sourcePath.substr(directoryOf(sourcePath).size());
+    size_t lastDot = sourceBase.find_last_of('.');
+    if (lastDot != std::string::npos) sourceBase = sourceBase.substr(0, lastDot);
+
+    std::vector<std::string> directories = {dir, directoryOf(sourcePath)};
+    directories.insert(directories.end(), searchDirectories.begin(), searchDirectories.end());
+
+    std::vector<std::string> names = {filename};
+    lastDot = filename.find_last_of('.');
+    if (lastDot != std::string::npos) {
+        std::string base = filename.substr(0, lastDot);
+        std::string ext = filename.substr(lastDot);
+        for (auto& c : ext) c = (char)std::tolower((unsigned char)c);
+        for (const char* alt : {".png", ".jpg", ".jpeg", ".tga", ".bmp"}) {
+            if (ext != alt) names.push_back(base + alt);
+        }
+    }
+
+    std::vector<std::string> paths = {path};
+    for (const std::string& name : names) {
+        for (const std::string& directory : directories) {
+            paths.push_back(directory + name);
+            paths.push_back(directory + "textures/" + name);
+            paths.push_back(directory + "Textures/" + name);
+            if (!sourceBase.empty()) paths.push_back(directory + sourceBase + ".fbm/" + name);
+        }
+        paths.push_back(name);
+    }
+    std::vector<std::string> unique;
+    for (const std::string& candidate : paths) {
+        if (std::find(unique.begin(), unique.end(), candidate) == unique.end()) unique.push_back(candidate);
+    }
+    return unique;
+}
+
+bool TextureBaker::decode(const CharacterAsset& asset, const std::string& path, const std::string& sourcePath,
+                          const std::vector<std::string>& searchDirectories, CharacterAsset::TextureLevel& image,
+                          std::string* resolvedPath) {
+    int width = 0, height = 0, channels = 0;
+    unsigned char* data = nullptr;
+    std::vector<std::string> tried;
+    if (resolvedPath) resolvedPath->clear();
+
+    if (path[0] == '*') {
+        const CharacterAsset::EmbeddedTexture* embedded = asset.getEmbeddedTexture(path);
+        if (embedded && embedded->height == 0) {
+            data = stbi_load_from_memory(embedded->data.data(), (int)embedded->data.size(), &width, &height, &channels, 4);
+        } else if (embedded) {
+            // Raw BGRA8888
+            image.width = embedded->width;
+            image.height = embedded->height;
+            image.data.resize((size_t)image.width * image.height * 4);
+            for (size_t i = 0; i < image.data.size(); i += 4) {
+                image.data[i] = embedded->data[i + 2];
+                image.data[i + 1] = embedded->data[i + 1];
+                image.data[i + 2] = embedded->data[i];
+                image.data[i + 3] = embedded->data[i + 3];
+            }
+            flipRows(image);
+            return true;
+        }
+    } else {
+        for (const std::string& candidate : candidatePaths(path, sourcePath, searchDirectories)) {
+            tried.push_back(candidate);
+            data = stbi_load(candidate.c_str(), &width, &height, &channels, 4);
+            if (data) {
+                if (resolvedPath) *resolvedPath = candidate;
+                break;
+            }
+        }
+    }
+
+    if (!data) {
+        std::cerr << "Texture failed to load: " << path << std::endl;
+        if (!tried.empty()) {
+            std::cerr << "Tried paths:" << std::endl;
+            for (const auto& t : tried) std::cerr << "  " << t << std::endl;
+        }
+        return false;
+    }
+    image.width = width;
+    image.height = height;
+    image.data.assign(data, data + (size_t)width * height * 4);
+    stbi_image_free(data);
+    // Flipped here rather than with stbi_set_flip_vertically_on_load, a global shared by the decode threads
+    flipRows(image);
+    return true;
+}
+
+bool TextureBaker::resolveFormat(const std::string& formatName, const std::string& textureName, bool alpha,
+                                 bool blockAligned, TextureFormat& format) {
+    if (formatName == "rgba8") format = TextureFormat::RGBA8;
+    else if (formatName == "bc") format = alpha ? TextureFormat::BC3 : TextureFormat::BC1;
+    else if (formatName == "etc2") format = alpha ? TextureFormat::ETC2_RGBA8 : TextureFormat::ETC2_RGB8;
+    else {
+        std::cerr << "Unknown texture format '" << formatName << "'" << std::endl;
+        return false;
+    }
+    // WebGL rejects block-compressed uploads whose base size isn't whole blocks
+    if (TextureCompression::isBlockCompressed(format) && !blockAligned) {
+        std::cerr << "Skipping " << formatName << " for " << textureName << ": size is not a multiple of 4" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+CharacterAsset::TexturePayload TextureBaker::encode(const std::vector<CharacterAsset::TextureLevel>& levels, TextureFormat format) {
+    CharacterAsset::TexturePayload payload;
+    payload.format = format;
+    payload.levels.reserve(levels.size());
+    for (const auto& level : levels) payload.levels.push_back(TextureCompression::compress(level, format));
+    return payload;
+}
+
+std::vector<TextureBakeReport> TextureBaker::bakeTextures(CharacterAsset& asset, const std::string& sourcePath,
+                                                          const std::vector<std::string>& searchDirectories,
+                                                          const std::vector<std::string>& formats, JobSystem* jobs) {
+    using Clock = std::chrono::steady_clock;
+    auto msSince = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+    std::vector<std::string> names;
+    for (const auto& mesh : asset.meshes) {
+        const std::string& name = mesh.texturePath;
+        if (!name.empty() && std::find(names.begin(), names.end(), name) == names.end()) names.push_back(name);
+    }
+
+    // Stage 1: find, decode and mip each texture
+    struct Source {
+        bool loaded = false;
+        std::vector<CharacterAsset::TextureLevel> levels;
+        std::vector<TextureFormat> formats;
+    };
+    std::vector<Source> sources(names.size());
+    std::vector<TextureBakeReport> reports(names.size());
+    auto decodeRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            auto start = Clock::now();
+            TextureBakeReport& report = reports[i];
+            report.name = names[i];
+            CharacterAsset::TextureLevel image;
+            if (!decode(asset, names[i], sourcePath, searchDirectories, image, &report.resolvedPath)) continue;
+            report.width = image.width;
+            report.height = image.height;
+            bool alpha = TextureCompression::hasAlpha(image);
+            bool blockAligned = image.width % 4 == 0 && image.height % 4 == 0;
+            for (const std::string& formatName : formats) {
+                TextureFormat format;
+                if (!resolveFormat(formatName, names[i], alpha, blockAligned, format)) continue;
+                if (std::find(sources[i].formats.begin(), sources[i].formats.end(), format) == sources[i].formats.end()) {
+                    sources[i].formats.push_back(format);
+                }
+            }
+            sources[i].levels = TextureCompression::generateMips(std::move(image));
+            sources[i].loaded = true;
+            report.levelCount = sources[i].levels.size();
+            report.decodeMs = msSince(start);
+        }
+    };
+    if (jobs) jobs->parallelFor(names.size(), 1, decodeRange);
+    else decodeRange(0, names.size());
+
+    // Stage 2: one task per (texture, format), since encoding dominates and textures are few
+    struct EncodeTask {
+        size_t texture;
+        size_t payload;
+    };
+    std::vector<EncodeTask> tasks;
+    std::vector<CharacterAsset::BakedTexture> textures(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        textures[i].name = names[i];
+        textures[i].width = reports[i].width;
+        textures[i].height = reports[i].height;
+        textures[i].payloads.resize(sources[i].formats.size());
+        for (size_t p = 0; p < sources[i].formats.size(); p++) tasks.push_back({i, p});
+    }
+    std::vector<double> encodeMs(tasks.size(), 0.0);
+    auto encodeRange = [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            auto start = Clock::now();
+            const EncodeTask& task = tasks[t];
+            const Source& source = sources[task.texture];
+            textures[task.texture].payloads[task.payload] = encode(source.levels, source.formats[task.payload]);
+            encodeMs[t] = msSince(start);
+        }
+    };
+    if (jobs) jobs->parallelFor(tasks.size(), 1, encodeRange);
+    else encodeRange(0, tasks.size());
+    for (size_t t = 0; t < tasks.size(); t++) reports[tasks[t].texture].encodeMs += encodeMs[t];
+
+    std::vector<TextureBakeReport> bakedReports;
+    asset.bakedTextures.clear();
+    for (size_t i = 0; i < names.size(); i++) {
+        if (!sources[i].loaded || textures[i].payloads.empty()) continue;
+        for (const auto& payload : textures[i].payloads) reports[i].payloadBytes.push_back({payload.format, payload.sizeInBytes()});
+        bakedReports.push_back(std::move(reports[i]));
+        asset.bakedTextures.push_back(std::move(textures[i]));
+    }
+    return bakedReports;
+}
+
+const char* TextureBaker::formatName(TextureFormat format) {
+    switch (format) {
+        case TextureFormat::RGBA8: return "RGBA8";
+        case TextureFormat::BC1: return "BC1";
+        case TextureFormat::BC3: return "BC3";
+        case TextureFormat::ETC2_RGB8: return "ETC2 RGB8";
+        case TextureFormat::ETC2_RGBA8: return "ETC2 RGBA8";
+    }
+    return "?";
+}
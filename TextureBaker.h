@@ -0,0 +1,57 @@
+#ifndef TEXTURE_BAKER_H
+#define TEXTURE_BAKER_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "CharacterAsset.h"
+#include "JobSystem.h"
+
+struct TextureBakeReport {
+    std::string name;
+    std::string resolvedPath;  // empty for embedded textures
+    int width = 0;
+    int height = 0;
+    size_t levelCount = 0;
+    std::vector<std::pair<CharacterAsset::TextureFormat, size_t>> payloadBytes;
+    double decodeMs = 0.0;  // file read, decode and mip generation
+    double encodeMs = 0.0;  // every payload, summed
+};
+
+// Finds and decodes the textures meshes reference (stb_image), so the runtimes get mip chains in
+// GPU formats and never search for or decode image files themselves. Tools only, like FBXImporter.
+class TextureBaker {
+public:
+    using TextureFormat = CharacterAsset::TextureFormat;
+
+    // Files to try for a mesh texture path, most likely first: as given, next to the source file,
+    // in textures/ and <source>.fbm/ folders, in each search directory, and with other extensions
+    static std::vector<std::string> candidatePaths(const std::string& path, const std::string& sourcePath,
+                                                   const std::vector<std::string>& searchDirectories);
+
+    // Decodes a file or "*<index>" embedded texture to RGBA8 rows bottom-up. Logs the tried
+    // paths and returns false if nothing loads.
+    static bool decode(const CharacterAsset& asset, const std::string& path, const std::string& sourcePath,
+                       const std::vector<std::string>& searchDirectories, CharacterAsset::TextureLevel& image,
+                       std::string* resolvedPath = nullptr);
+
+    // Bakes the texture of every mesh into the asset, replacing earlier bakes. Textures that
+    // can't be found are skipped (the mesh renders untextured). With jobs, textures are decoded
+    // in parallel, then every (texture, format) payload is encoded as its own task. formats holds
+    // "bc", "etc2" and/or "rgba8" in the order to store them; bc and etc2 pick their alpha
+    // variant from the image and need a size divisible by 4.
+    static std::vector<TextureBakeReport> bakeTextures(CharacterAsset& asset, const std::string& sourcePath,
+                                                       const std::vector<std::string>& searchDirectories,
+                                                       const std::vector<std::string>& formats, JobSystem* jobs = nullptr);
+
+    static const char* formatName(TextureFormat format);
+
+private:
+    // Encoding a format name stands for with this image; false (and logged) if it is unknown or
+    // needs a block-aligned size
+    static bool resolveFormat(const std::string& formatName, const std::string& textureName, bool alpha,
+                              bool blockAligned, TextureFormat& format);
+    static CharacterAsset::TexturePayload encode(const std::vector<CharacterAsset::TextureLevel>& levels, TextureFormat format);
+};
+
+#endif
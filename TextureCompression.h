@@ -0,0 +1,382 @@
+#ifndef TEXTURE_COMPRESSION_H
+#define TEXTURE_COMPRESSION_H
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "CharacterAsset.h"
+
+// Bake-time mip generation and block compression into the formats of CharacterAsset::TextureFormat.
+// Every encoder works on 4x4 blocks of RGBA8 texels, edge blocks padded by repeating the last
+// row/column. The encoders aim for fast, predictable bakes rather than best quality: BC endpoints
+// come from the colours' principal axis, ETC2 blocks use the ETC1-compatible individual and
+// differential modes only.
+class TextureCompression {
+public:
+    using TextureFormat = CharacterAsset::TextureFormat;
+    using TextureLevel = CharacterAsset::TextureLevel;
+
+    static bool isBlockCompressed(TextureFormat format) { return format != TextureFormat::RGBA8; }
+
+    static size_t blockSize(TextureFormat format) {
+        return (format == TextureFormat::BC1 || format == TextureFormat::ETC2_RGB8) ? 8 : 16;
+    }
+
+    static size_t levelSize(TextureFormat format, int width, int height) {
+        if (!isBlockCompressed(format)) return (size_t)width * height * 4;
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize(format);
+    }
+
+    static bool hasAlpha(const TextureLevel& level) {
+        for (size_t i = 3; i < level.data.size(); i += 4) {
+            if (level.data[i] != 255) return true;
+        }
+        return false;
+    }
+
+    // Full chain down to 1x1 with a 2x2 box filter; odd edges reuse the last texel
+    static std::vector<TextureLevel> generateMips(TextureLevel base) {
+        std::vector<TextureLevel> levels;
+        levels.push_back(std::move(base));
+        while (levels.back().width > 1 || levels.back().height > 1) {
+            const TextureLevel& source = levels.back();
+            TextureLevel level;
+            level.width = std::max(1, source.width / 2);
+            level.height = std::max(1, source.height / 2);
+            level.data.resize((size_t)level.width * level.height * 4);
+            for (int y = 0; y < level.height; y++) {
+                int y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+                for (int x = 0; x < level.width; x++) {
+                    int x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+                    for (int c = 0; c < 4; c++) {
+                        int sum = source.data[((size_t)y0 * source.width + x0) * 4 + c] + source.data[((size_t)y0 * source.width + x1) * 4 + c]
+                                + source.data[((size_t)y1 * source.width + x0) * 4 + c] + source.data[((size_t)y1 * source.width + x1) * 4 + c];
+                        level.data[((size_t)y * level.width + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+                    }
+                }
+            }
+            levels.push_back(std::move(level));
+        }
+        return levels;
+    }
+
+    // Encodes one RGBA8 level; RGBA8 is returned as is
+    static TextureLevel compress(const TextureLevel& level, TextureFormat format) {
+        if (!isBlockCompressed(format)) return level;
+        TextureLevel result;
+        result.width = level.width;
+        result.height = level.height;
+        result.data.resize(levelSize(format, level.width, level.height));
+        uint8_t* out = result.data.data();
+        uint8_t block[64];
+        for (int by = 0; by < level.height; by += 4) {
+            for (int bx = 0; bx < level.width; bx += 4) {
+                for (int y = 0; y < 4; y++) {
+                    int sy = std::min(by + y, level.height - 1);
+                    for (int x = 0; x < 4; x++) {
+                        int sx = std::min(bx + x, level.width - 1);
+                        std::memcpy(&block[(y * 4 + x) * 4], &level.data[((size_t)sy * level.width + sx) * 4], 4);
+                    }
+                }
+                switch (format) {
+                    case TextureFormat::BC1: encodeBC1(block, out); break;
+                    case TextureFormat::BC3: encodeBC3(block, out); break;
+                    case TextureFormat::ETC2_RGB8: encodeETC2RGB(block, out); break;
+                    case TextureFormat::ETC2_RGBA8: encodeETC2RGBA(block, out); break;
+                    default: break;
+                }
+                out += blockSize(format);
+            }
+        }
+        return result;
+    }
+
+    // block: 16 RGBA8 texels, row-major. Output sizes follow blockSize().
+    static void encodeBC1(const uint8_t* block, uint8_t* out) { encodeBCColor(block, out); }
+
+    static void encodeBC3(const uint8_t* block, uint8_t* out) {
+        encodeBCAlpha(block, out);
+        encodeBCColor(block, out + 8);
+    }
+
+    static void encodeETC2RGB(const uint8_t* block, uint8_t* out) { encodeETCColor(block, out); }
+
+    static void encodeETC2RGBA(const uint8_t* block, uint8_t* out) {
+        encodeEACAlpha(block, out);
+        encodeETCColor(block, out + 8);
+    }
+
+    static constexpr int kETCModifiers[8][2] = {
+        {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+    };
+
+    static constexpr int kEACModifiers[16][8] = {
+        {-3, -6, -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12}, {-2, -5, -8, -13, 1, 4, 7, 12},
+        {-2, -4, -6, -13, 1, 3, 5, 12}, {-3, -6, -8, -12, 2, 5, 7, 11}, {-3, -7, -9, -11, 2, 6, 8, 10},
+        {-4, -7, -8, -11, 3, 6, 7, 10}, {-3, -5, -8, -11, 2, 4, 7, 10}, {-2, -6, -8, -10, 1, 5, 7, 9},
+        {-2, -5, -8, -10, 1, 4, 7, 9}, {-2, -4, -8, -10, 1, 3, 7, 9}, {-2, -5, -7, -10, 1, 4, 6, 9},
+        {-3, -4, -7, -10, 2, 3, 6, 9}, {-1, -2, -3, -10, 0, 1, 2, 9}, {-4, -6, -8, -9, 3, 5, 7, 8},
+        {-3, -5, -7, -9, 2, 4, 6, 8}
+    };
+
+private:
+    static int colorDistance(const uint8_t* a, const int* b) {
+        int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+        return dr * dr + dg * dg + db * db;
+    }
+
+    static uint16_t to565(const float* color) {
+        int r = std::clamp((int)std::lround(color[0] * 31.0f / 255.0f), 0, 31);
+        int g = std::clamp((int)std::lround(color[1] * 63.0f / 255.0f), 0, 63);
+        int b = std::clamp((int)std::lround(color[2] * 31.0f / 255.0f), 0, 31);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    static void from565(uint16_t c, int* color) {
+        int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // BC1 colour block in 4-colour mode (color0 > color1), which BC3 always assumes anyway.
+    // Endpoints are the texels furthest apart along the principal axis of the block's colours.
+    static void encodeBCColor(const uint8_t* block, uint8_t* out) {
+        float mean[3] = {0, 0, 0};
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 3; c++) mean[c] += block[i * 4 + c] / 16.0f;
+        }
+        float cov[6] = {0, 0, 0, 0, 0, 0};  // rr rg rb gg gb bb
+        for (int i = 0; i < 16; i++) {
+            float r = block[i * 4] - mean[0], g = block[i * 4 + 1] - mean[1], b = block[i * 4 + 2] - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+        float axis[3] = {1.0f, 1.0f, 1.0f};
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[3] = {
+                cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]
+            };
+            float length = std::max({std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2])});
+            if (length < 1e-6f) break;
+            for (int c = 0; c < 3; c++) axis[c] = next[c] / length;
+        }
+        int minIndex = 0, maxIndex = 0;
+        float minDot = 1e30f, maxDot = -1e30f;
+        for (int i = 0; i < 16; i++) {
+            float dot = block[i * 4] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+            if (dot < minDot) { minDot = dot; minIndex = i; }
+            if (dot > maxDot) { maxDot = dot; maxIndex = i; }
+        }
+        float high[3], low[3];
+        for (int c = 0; c < 3; c++) {
+            high[c] = block[maxIndex * 4 + c];
+            low[c] = block[minIndex * 4 + c];
+        }
+        uint16_t color0 = to565(high), color1 = to565(low);
+        if (color0 < color1) std::swap(color0, color1);
+
+        uint32_t indices = 0;
+        if (color0 != color1) {
+            int palette[4][3];
+            from565(color0, palette[0]);
+            from565(color1, palette[1]);
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (int i = 0; i < 16; i++) {
+                int best = 0, bestError = colorDistance(&block[i * 4], palette[0]);
+                for (int p = 1; p < 4; p++) {
+                    int error = colorDistance(&block[i * 4], palette[p]);
+                    if (error < bestError) { bestError = error; best = p; }
+                }
+                indices |= (uint32_t)best << (i * 2);
+            }
+        }
+        out[0] = (uint8_t)(color0 & 0xFF); out[1] = (uint8_t)(color0 >> 8);
+        out[2] = (uint8_t)(color1 & 0xFF); out[3] = (uint8_t)(color1 >> 8);
+        for (int b = 0; b < 4; b++) out[4 + b] = (uint8_t)(indices >> (b * 8));
+    }
+
+    // BC3/BC4 alpha block in 8-value mode between the block's extremes
+    static void encodeBCAlpha(const uint8_t* block, uint8_t* out) {
+        int alpha0 = 0, alpha1 = 255;
+        for (int i = 0; i < 16; i++) {
+            alpha0 = std::max(alpha0, (int)block[i * 4 + 3]);
+            alpha1 = std::min(alpha1, (int)block[i * 4 + 3]);
+        }
+        uint64_t indices = 0;
+        if (alpha0 != alpha1) {
+            int values[8] = {alpha0, alpha1};
+            for (int k = 1; k < 7; k++) values[k + 1] = ((7 - k) * alpha0 + k * alpha1) / 7;
+            for (int i = 0; i < 16; i++) {
+                int best = 0, bestError = 256;
+                for (int k = 0; k < 8; k++) {
+                    int error = std::abs(block[i * 4 + 3] - values[k]);
+                    if (error < bestError) { bestError = error; best = k; }
+                }
+                indices |= (uint64_t)best << (i * 3);
+            }
+        }
+        out[0] = (uint8_t)alpha0;
+        out[1] = (uint8_t)alpha1;
+        for (int b = 0; b < 6; b++) out[2 + b] = (uint8_t)(indices >> (b * 8));
+    }
+
+    // Best modifier table and per-texel indices for one ETC subblock around base. Returns the error.
+    static int fitETCSubblock(const uint8_t* block, const int* pixels, const int* base, int& table, int* selectors) {
+        int bestError = INT32_MAX;
+        for (int t = 0; t < 8; t++) {
+            const int modifiers[4] = {kETCModifiers[t][0], kETCModifiers[t][1], -kETCModifiers[t][0], -kETCModifiers[t][1]};
+            int error = 0, chosen[8];
+            for (int p = 0; p < 8 && error < bestError; p++) {
+                const uint8_t* texel = &block[pixels[p] * 4];
+                int bestPixel = INT32_MAX;
+                for (int k = 0; k < 4; k++) {
+                    int color[3];
+                    for (int c = 0; c < 3; c++) color[c] = std::clamp(base[c] + modifiers[k], 0, 255);
+                    int e = colorDistance(texel, color);
+                    if (e < bestPixel) { bestPixel = e; chosen[p] = k; }
+                }
+                error += bestPixel;
+            }
+            if (error < bestError) {
+                bestError = error;
+                table = t;
+                std::copy(chosen, chosen + 8, selectors);
+            }
+        }
+        return bestError;
+    }
+
+    // ETC1-compatible block (valid ETC2 RGB8): for both subblock orientations, tries differential
+    // mode (555 base + 333 delta) when the averages are close enough and individual mode (two 444
+    // bases) otherwise or if better, keeping whichever encoding has the lowest error.
+    static void encodeETCColor(const uint8_t* block, uint8_t* out) {
+        uint64_t bestBits = 0;
+        int bestError = INT32_MAX;
+        for (int flip = 0; flip < 2; flip++) {
+            // Texel indices (row-major) of each subblock: left/right halves, or top/bottom with flip
+            int pixels[2][8];
+            int counts[2] = {0, 0};
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    int half = flip ? (y >= 2) : (x >= 2);
+                    pixels[half][counts[half]++] = y * 4 + x;
+                }
+            }
+            float average[2][3] = {};
+            for (int s = 0; s < 2; s++) {
+                for (int p = 0; p < 8; p++) {
+                    for (int c = 0; c < 3; c++) average[s][c] += block[pixels[s][p] * 4 + c] / 8.0f;
+                }
+            }
+
+            for (int differential = 1; differential >= 0; differential--) {
+                int quantized[2][3], base[2][3];
+                bool fits = true;
+                for (int s = 0; s < 2; s++) {
+                    for (int c = 0; c < 3; c++) {
+                        if (differential) {
+                            quantized[s][c] = std::clamp((int)std::lround(average[s][c] * 31.0f / 255.0f), 0, 31);
+                            base[s][c] = (quantized[s][c] << 3) | (quantized[s][c] >> 2);
+                        } else {
+                            quantized[s][c] = std::clamp((int)std::lround(average[s][c] * 15.0f / 255.0f), 0, 15);
+                            base[s][c] = (quantized[s][c] << 4) | quantized[s][c];
+                        }
+                    }
+                }
+                if (differential) {
+                    for (int c = 0; c < 3; c++) {
+                        int delta = quantized[1][c] - quantized[0][c];
+                        if (delta < -4 || delta > 3) fits = false;
+                    }
+                    if (!fits) continue;
+                }
+
+                int tables[2], selectors[2][8];
+                int error = fitETCSubblock(block, pixels[0], base[0], tables[0], selectors[0])
+                          + fitETCSubblock(block, pixels[1], base[1], tables[1], selectors[1]);
+                if (error >= bestError) continue;
+                bestError = error;
+
+                uint64_t bits = 0;
+                for (int c = 0; c < 3; c++) {
+                    int shift = 56 - c * 8;
+                    if (differential) {
+                        int delta = quantized[1][c] - quantized[0][c];
+                        bits |= (uint64_t)quantized[0][c] << (shift + 3);
+                        bits |= (uint64_t)(delta & 7) << shift;
+                    } else {
+                        bits |= (uint64_t)quantized[0][c] << (shift + 4);
+                        bits |= (uint64_t)quantized[1][c] << shift;
+                    }
+                }
+                bits |= (uint64_t)tables[0] << 37;
+                bits |= (uint64_t)tables[1] << 34;
+                bits |= (uint64_t)differential << 33;
+                bits |= (uint64_t)flip << 32;
+                // Selector bits are stored column-major: texel (x, y) is bit x * 4 + y
+                for (int s = 0; s < 2; s++) {
+                    for (int p = 0; p < 8; p++) {
+                        int texel = pixels[s][p];
+                        int bit = (texel % 4) * 4 + texel / 4;
+                        bits |= (uint64_t)(selectors[s][p] >> 1) << (16 + bit);
+                        bits |= (uint64_t)(selectors[s][p] & 1) << bit;
+                    }
+                }
+                bestBits = bits;
+            }
+        }
+        for (int b = 0; b < 8; b++) out[b] = (uint8_t)(bestBits >> (56 - b * 8));
+    }
+
+    // ETC2 EAC alpha block: per modifier table, the multiplier and base that span the block's
+    // alpha range, then the nearest modifier per texel
+    static void encodeEACAlpha(const uint8_t* block, uint8_t* out) {
+        int minAlpha = 255, maxAlpha = 0;
+        for (int i = 0; i < 16; i++) {
+            minAlpha = std::min(minAlpha, (int)block[i * 4 + 3]);
+            maxAlpha = std::max(maxAlpha, (int)block[i * 4 + 3]);
+        }
+        int bestError = INT32_MAX, bestBase = minAlpha, bestMultiplier = 1, bestTable = 13;
+        uint64_t bestIndices = 0;
+        for (int t = 0; t < 16; t++) {
+            const int* modifiers = kEACModifiers[t];
+            int tableMin = *std::min_element(modifiers, modifiers + 8), tableMax = *std::max_element(modifiers, modifiers + 8);
+            int multiplier = std::clamp((int)std::lround((float)(maxAlpha - minAlpha) / (tableMax - tableMin)), 1, 15);
+            int base = std::clamp((int)std::lround((minAlpha + maxAlpha) * 0.5f - (tableMin + tableMax) * 0.5f * multiplier), 0, 255);
+            int error = 0;
+            uint64_t indices = 0;
+            for (int i = 0; i < 16 && error < bestError; i++) {
+                int alpha = block[i * 4 + 3];
+                int best = 0, bestPixel = INT32_MAX;
+                for (int k = 0; k < 8; k++) {
+                    int e = std::abs(alpha - std::clamp(base + modifiers[k] * multiplier, 0, 255));
+                    if (e < bestPixel) { bestPixel = e; best = k; }
+                }
+                error += bestPixel * bestPixel;
+                // Column-major like the colour selectors, first texel in the top bits
+                int x = i % 4, y = i / 4;
+                indices |= (uint64_t)best << (45 - (x * 4 + y) * 3);
+            }
+            if (error < bestError) {
+                bestError = error;
+                bestBase = base;
+                bestMultiplier = multiplier;
+                bestTable = t;
+                bestIndices = indices;
+            }
+        }
+        out[0] = (uint8_t)bestBase;
+        out[1] = (uint8_t)((bestMultiplier << 4) | bestTable);
+        for (int b = 0; b < 6; b++) out[2 + b] = (uint8_t)(bestIndices >> (40 - b * 8));
+    }
+};
+
+#endif
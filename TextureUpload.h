@@ -0,0 +1,144 @@
+#ifndef TEXTURE_UPLOAD_H
+#define TEXTURE_UPLOAD_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "CharacterAsset.h"
+#include "AssetDatabase.h"
+
+#ifdef __EMSCRIPTEN__
+#include <GLES3/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
+// Creates GL textures from baked mip chains: picks the first payload the context can sample and
+// uploads its levels as stored, with no decode and no glGenerateMipmap.
+class TextureUpload {
+public:
+    struct Support {
+        bool bc = false;    // S3TC / DXT
+        bool etc2 = false;
+    };
+
+    // Needs a current context. Desktop GL and WebGL 2 both expose block formats as extensions;
+    // Emscripten lists WebGL extensions with and without a "GL_" prefix.
+    static Support querySupport() {
+        Support support;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (!name) continue;
+            std::string extension = name;
+            if (endsWith(extension, "texture_compression_s3tc") || endsWith(extension, "compressed_texture_s3tc")) support.bc = true;
+            if (endsWith(extension, "compressed_texture_etc") || extension == "GL_ARB_ES3_compatibility") support.etc2 = true;
+        }
+        return support;
+    }
+
+    static bool isSupported(CharacterAsset::TextureFormat format, const Support& support) {
+        switch (format) {
+            case CharacterAsset::TextureFormat::RGBA8: return true;
+            case CharacterAsset::TextureFormat::BC1:
+            case CharacterAsset::TextureFormat::BC3: return support.bc;
+            case CharacterAsset::TextureFormat::ETC2_RGB8:
+            case CharacterAsset::TextureFormat::ETC2_RGBA8: return support.etc2;
+        }
+        return false;
+    }
+
+    static const CharacterAsset::TexturePayload* choosePayload(const CharacterAsset::BakedTexture& texture, const Support& support) {
+        for (const auto& payload : texture.payloads) {
+            if (!payload.levels.empty() && isSupported(payload.format, support)) return &payload;
+        }
+        return nullptr;
+    }
+
+    // Returns 0 if the texture has no payload this context supports
+    static GLuint upload(const CharacterAsset::BakedTexture& texture, const Support& support) {
+        const CharacterAsset::TexturePayload* payload = choosePayload(texture, support);
+        if (!payload) {
+            std::cerr << "No supported format baked for texture " << texture.name << std::endl;
+            return 0;
+        }
+
+        GLuint tex;
+        glGenTextures(1, &tex);
+        uploadLevels(tex, payload->format, 0, payload->levels, (uint32_t)payload->levels.size());
+        return tex;
+    }
+
+    // Uploads levels firstLevel onwards of a levelCount-level chain and samples from firstLevel
+    // down. Streamed textures arrive coarsest first, so each call adds finer levels above the
+    // ones already there and moves the base level up to them.
+    static void uploadLevels(GLuint tex, CharacterAsset::TextureFormat format, uint32_t firstLevel,
+                             const std::vector<CharacterAsset::TextureLevel>& levels, uint32_t levelCount) {
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        GLenum internalFormat = glFormat(format);
+        for (size_t i = 0; i < levels.size(); i++) {
+            const CharacterAsset::TextureLevel& level = levels[i];
+            GLint index = (GLint)(firstLevel + i);
+            if (format == CharacterAsset::TextureFormat::RGBA8) {
+                glTexImage2D(GL_TEXTURE_2D, index, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data.data());
+            } else {
+                glCompressedTexImage2D(GL_TEXTURE_2D, index, internalFormat, level.width, level.height, 0,
+                                       (GLsizei)level.data.size(), level.data.data());
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)firstLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levelCount - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount - firstLevel > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    // Uploads and frees AssetDatabase textures in this context, sized by the payload chosen
+    static AssetDatabase::TextureBackend databaseBackend(const Support& support) {
+        AssetDatabase::TextureBackend backend;
+        backend.upload = [support](const CharacterAsset::BakedTexture& texture, size_t& bytes) {
+            const CharacterAsset::TexturePayload* payload = choosePayload(texture, support);
+            bytes = payload ? payload->sizeInBytes() : 0;
+            return (uint32_t)upload(texture, support);
+        };
+        backend.release = [](uint32_t id) {
+            GLuint texture = id;
+            glDeleteTextures(1, &texture);
+        };
+        return backend;
+    }
+
+private:
+    static GLenum glFormat(CharacterAsset::TextureFormat format) {
+        switch (format) {
+            case CharacterAsset::TextureFormat::RGBA8: return GL_RGBA8;
+            case CharacterAsset::TextureFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case CharacterAsset::TextureFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case CharacterAsset::TextureFormat::ETC2_RGB8: return GL_COMPRESSED_RGB8_ETC2;
+            case CharacterAsset::TextureFormat::ETC2_RGBA8: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        }
+        return GL_RGBA8;
+    }
+
+    static bool endsWith(const std::string& text, const std::string& suffix) {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+};
+
+#endif
@@ -0,0 +1,153 @@
+// Compares compressed clip sampling against the raw keys it was built from, on a clip where some
+// bones have no channel and others are missing single tracks, and reports the per-bone cost of
+// each. Then plays the clip double-buffered with LOD-style skipped updates. Exits non-zero if the
+// poses differ by more than the compression tolerances allow, or if either palette view falls
+// behind the newest frame.
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <span>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "CharacterAsset.h"
+#include "FBXStateMachine.h"
+
+// Bone i gets: no channel (i % 4 == 0), every track (1), no scale track (2), rotation only (3).
+// Bind poses are far from the zero/identity a missing track could decode to.
+static std::shared_ptr<CharacterAsset> makeAsset(int boneCount, int keyCount, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    Skeleton skeleton;
+    for (int i = 0; i < boneCount; i++) {
+        BoneTransform bind;
+        bind.translation = glm::vec3(unit(rng) * 0.1f, 0.3f, unit(rng) * 0.1f);
+        bind.rotation = glm::normalize(glm::quat(unit(rng) + 2.0f, unit(rng), unit(rng), unit(rng)));
+        bind.scale = glm::vec3(1.2f);
+        skeleton.addBone("bone" + std::to_string(i), i - 1, bind);
+    }
+
+    CharacterAsset::CompiledClip clip;
+    clip.name = "check";
+    clip.duration = 100.0f;
+    clip.channelForBone.assign(boneCount, -1);
+    for (int i = 0; i < boneCount; i++) {
+        if (i % 4 == 0) continue;
+        clip.channelForBone[i] = (int)clip.channels.size();
+        RawChannel channel;
+        float phase = unit(rng) * 3.0f;
+        for (int k = 0; k < keyCount; k++) {
+            float time = clip.duration * k / (keyCount - 1);
+            float angle = 0.5f * std::sin(time * 0.1f + phase);
+            channel.rotations.push_back({time, glm::angleAxis(angle, glm::normalize(glm::vec3(1.0f, phase, 0.5f)))});
+            if (i % 4 == 3) continue;
+            channel.positions.push_back({time, glm::vec3(0.0f, 0.3f, 0.0f) + 0.1f * glm::vec3(std::sin(time * 0.07f + phase))});
+            if (i % 4 == 2) continue;
+            channel.scalings.push_back({time, glm::vec3(1.0f + 0.1f * std::cos(time * 0.05f + phase))});
+        }
+        clip.channels.push_back(std::move(channel));
+    }
+    return CharacterAsset::fromAnimation(std::move(skeleton), {clip});
+}
+
+static bool samePalette(std::span<const glm::mat4> a, const glm::mat4* b) {
+    return std::equal(a.begin(), a.end(), b);
+}
+
+// A double-buffered instance is updated only on some frames but swapped on every one, the way
+// the LOD scheduler and a render loop drive it. A single-buffered twin updated in lockstep holds
+// the newest frame; the reader must see it after every swap, getBones() right after every update.
+static bool checkDoubleBuffering(const std::shared_ptr<const CharacterAsset>& asset) {
+    FBXStateMachine buffered(asset), reference(asset);
+    buffered.setBakedPlayback(BakedPlayback::Disabled);
+    reference.setBakedPlayback(BakedPlayback::Disabled);
+    buffered.setDoubleBuffered(true);
+
+    const bool updates[] = {true, false, true, true, false, false, true};
+    int frame = 0;
+    for (bool update : updates) {
+        if (update) {
+            buffered.update(0.1f);
+            reference.update(0.1f);
+        }
+        std::span<const glm::mat4> newest = reference.getFinalBoneMatrices();
+        bool bonesOk = samePalette(newest, buffered.getBones().getPalette());
+        buffered.swapPaletteBuffers();
+        bool readerOk = samePalette(newest, buffered.getFinalBoneMatrices().data()) &&
+                        samePalette(newest, buffered.getBones().getPalette());
+        if (!bonesOk || !readerOk) {
+            std::cerr << "Frame " << frame << (update ? "" : " (skipped)") << ": "
+                      << (bonesOk ? "the swapped palette" : "getBones()") << " is not the newest pose" << std::endl;
+            return false;
+        }
+        frame++;
+    }
+    std::cout << "Double buffering: " << frame << " frames, palettes stay on the newest pose\n";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int boneCount = argc > 1 ? std::atoi(argv[1]) : 64;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const int keyCount = 101;
+
+    std::mt19937 rng(1234);
+    auto raw = makeAsset(boneCount, keyCount, rng);
+    rng.seed(1234);
+    auto compressed = makeAsset(boneCount, keyCount, rng);
+    CompressionSettings settings;
+    settings.enabled = true;
+    compressed->compressClips(settings);
+
+    const CharacterAsset::CompiledClip& rawClip = raw->getClips()[0];
+    const CharacterAsset::CompiledClip& compressedClip = compressed->getClips()[0];
+    std::vector<KeyCursor> rawCursors(boneCount), compressedCursors(boneCount);
+    std::vector<BoneTransform> rawPose(boneCount), compressedPose(boneCount);
+
+    // Between keys the runtime interpolates differently (nlerp vs slerp) on top of the key
+    // reduction and quantization errors, so allow twice the budget
+    float maxTranslation = 0.0f, maxRotation = 0.0f, maxScale = 0.0f;
+    const int steps = 1000;
+    for (int s = 0; s <= steps; s++) {
+        float time = rawClip.duration * s / steps;
+        raw->sampleClip(time, &rawClip, rawCursors.data(), rawPose.data());
+        compressed->sampleClip(time, &compressedClip, compressedCursors.data(), compressedPose.data());
+        for (int i = 0; i < boneCount; i++) {
+            maxTranslation = std::max(maxTranslation, glm::length(rawPose[i].translation - compressedPose[i].translation));
+            maxScale = std::max(maxScale, glm::length(rawPose[i].scale - compressedPose[i].scale));
+            float dot = std::min(1.0f, std::abs(glm::dot(rawPose[i].rotation, compressedPose[i].rotation)));
+            maxRotation = std::max(maxRotation, 2.0f * std::acos(dot));
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        raw->sampleClip(rawClip.duration * it / iterations, &rawClip, rawCursors.data(), rawPose.data());
+    }
+    double rawNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        compressed->sampleClip(compressedClip.duration * it / iterations, &compressedClip, compressedCursors.data(), compressedPose.data());
+    }
+    double compressedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    volatile float sink = rawPose.back().translation.y + compressedPose.back().translation.y;
+    (void)sink;
+
+    double perBone = (double)boneCount * iterations;
+    std::cout << "Bones: " << boneCount << ", keys per track: " << keyCount << ", iterations: " << iterations << "\n";
+    std::cout << "Raw:        " << rawNs / perBone << " ns/bone\n";
+    std::cout << "Compressed: " << compressedNs / perBone << " ns/bone\n";
+    std::cout << "Max error: translation " << maxTranslation << ", rotation " << maxRotation << " rad, scale " << maxScale << "\n";
+
+    if (maxTranslation > 2.0f * settings.translationTolerance || maxRotation > 2.0f * settings.rotationTolerance ||
+        maxScale > 2.0f * settings.scaleTolerance) {
+        std::cerr << "Compressed sampling differs from the raw keys beyond tolerance" << std::endl;
+        return 1;
+    }
+    return checkDoubleBuffering(raw) ? 0 : 1;
+}
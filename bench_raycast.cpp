@@ -0,0 +1,193 @@
+// Compares CapsuleRaycast::nearest (SIMD lanes) against the one-capsule-at-a-time loop on random
+// rays through a character-sized cluster of capsules, and reports the cost of each per ray-capsule
+// test. Then compares PhysicsScene::raycast against testing every character of a crowd in turn.
+// Exits non-zero if any ray hits a different capsule or at a different distance, or if a hit lies
+// behind the ray's origin.
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "CapsuleRaycast.h"
+#include "PhysicsScene.h"
+
+const float tolerance = 1e-4f;
+
+// Characters on a 3 m grid, each a chain of 20 bones with a capsule per bone; every few are moved
+// between scene updates so some leaves get reinserted. Half the rays come down onto a random
+// character, the other half start at a random point inside a character's box.
+static bool checkScene(int characterCount, int rayCount) {
+    std::mt19937 rng(5678);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    const int boneCount = 20;
+    Skeleton skeleton;
+    std::vector<Capsule> config;
+    for (int i = 0; i < boneCount; i++) {
+        BoneTransform bind;
+        bind.translation = glm::vec3(unit(rng) * 0.2f, 0.1f, unit(rng) * 0.2f);
+        skeleton.addBone("bone" + std::to_string(i), i - 1, bind);
+        config.push_back({"bone" + std::to_string(i), 0.1f, 0.1f, 1.0f});
+    }
+    std::vector<glm::mat4> world(boneCount), palette(boneCount);
+    skeleton.evaluate(skeleton.bindPose.data(), world.data(), palette.data());
+
+    std::vector<CharacterPhysics> characters(characterCount);
+    std::vector<glm::vec3> positions(characterCount);
+    PhysicsScene scene;
+    int columns = (int)std::ceil(std::sqrt((float)characterCount));
+    for (int i = 0; i < characterCount; i++) {
+        positions[i] = glm::vec3((i % columns) * 3.0f, 0.0f, (i / columns) * 3.0f);
+        characters[i].setupColliders(config, skeleton);
+        characters[i].update(palette.data(), boneCount, glm::translate(glm::mat4(1.0f), positions[i]));
+        scene.add(characters[i]);
+    }
+    for (int tick = 0; tick < 5; tick++) {
+        scene.update();
+        for (int i = 0; i < characterCount; i += 7) {
+            positions[i] += glm::vec3(unit(rng), 0.0f, unit(rng)) * 0.5f;
+            characters[i].update(palette.data(), boneCount, glm::translate(glm::mat4(1.0f), positions[i]));
+        }
+    }
+    scene.update();
+    scene.resetStats();
+
+    std::vector<Ray> rays;
+    for (int i = 0; i < rayCount; i++) {
+        int c = (int)(rng() % characterCount);
+        if (i % 2) {
+            glm::vec3 low, high;
+            characters[c].bounds(low, high);
+            glm::vec3 origin = low + (high - low) * 0.5f * (glm::vec3(unit(rng), unit(rng), unit(rng)) + 1.0f);
+            rays.push_back({origin, glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-3f)), 100.0f});
+            continue;
+        }
+        glm::vec3 target = positions[c] + glm::vec3(unit(rng) * 0.2f, 1.0f + unit(rng), unit(rng) * 0.2f);
+        glm::vec3 origin = target + glm::vec3(unit(rng) * 5.0f, 20.0f, unit(rng) * 5.0f);
+        rays.push_back({origin, glm::normalize(target - origin), 100.0f});
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<float> bruteT(rayCount, -1.0f);
+    auto start = Clock::now();
+    for (int i = 0; i < rayCount; i++) {
+        Ray clipped = rays[i];
+        for (const auto& character : characters) {
+            HitResult hit;
+            if (character.raycast(clipped, hit)) clipped.maxDistance = bruteT[i] = hit.distance;
+        }
+    }
+    double bruteNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    std::vector<PhysicsScene::Hit> sceneHits(rayCount);
+    start = Clock::now();
+    for (int i = 0; i < rayCount; i++) {
+        if (!scene.raycast(rays[i], sceneHits[i])) sceneHits[i] = PhysicsScene::Hit();
+    }
+    double sceneNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    // Bodies tied at the same distance may differ, so only the distances are compared
+    int hits = 0, mismatches = 0, behind = 0;
+    for (int i = 0; i < rayCount; i++) {
+        bool found = sceneHits[i].body >= 0;
+        hits += found;
+        behind += found && sceneHits[i].hit.distance < 0.0f;
+        if (found != (bruteT[i] >= 0.0f) || (found && std::abs(sceneHits[i].hit.distance - bruteT[i]) > tolerance)) mismatches++;
+    }
+
+    PhysicsScene::Stats stats = scene.getStats();
+    std::cout << "\nCharacters: " << characterCount << ", tree height " << scene.treeHeight() << ", rays: " << rayCount
+              << ", hits: " << hits << "\n";
+    std::cout << "Every character: " << bruteNs / rayCount << " ns/ray\n";
+    std::cout << "Scene:           " << sceneNs / rayCount << " ns/ray, " << (double)stats.nodesVisited / stats.rays
+              << " nodes and " << (double)stats.bodiesTested / stats.rays << " characters tested per ray\n";
+    std::cout << "Different hit: " << mismatches << ", hits behind the origin: " << behind << "\n";
+
+    if (mismatches > 0 || behind > 0) {
+        std::cerr << "PhysicsScene results differ from testing every character" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int capsuleCount = argc > 1 ? std::atoi(argv[1]) : 16;
+    int rayCount = argc > 2 ? std::atoi(argv[2]) : 200000;
+    int characterCount = argc > 3 ? std::atoi(argv[3]) : 500;
+
+    // Capsules scattered over a 2 m tall body; rays aimed at random points of it from a few meters
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<float> startX, startY, startZ, endX, endY, endZ, radius;
+    for (int i = 0; i < capsuleCount; i++) {
+        glm::vec3 a(unit(rng) * 0.4f, 1.0f + unit(rng), unit(rng) * 0.2f);
+        glm::vec3 b = a + glm::vec3(unit(rng), unit(rng), unit(rng)) * 0.25f;
+        startX.push_back(a.x), startY.push_back(a.y), startZ.push_back(a.z);
+        endX.push_back(b.x), endY.push_back(b.y), endZ.push_back(b.z);
+        radius.push_back(0.05f + 0.05f * (unit(rng) + 1.0f));
+    }
+    CapsuleSoA capsules = {startX.data(), startY.data(), startZ.data(), endX.data(), endY.data(), endZ.data(),
+                           radius.data(), (size_t)capsuleCount};
+
+    // Every fourth ray starts at a capsule's axis (inside it) and points anywhere, so hits behind
+    // the origin are exercised too
+    std::vector<Ray> rays;
+    for (int i = 0; i < rayCount; i++) {
+        if (i % 4 == 3) {
+            int c = i % capsuleCount;
+            glm::vec3 origin(startX[c], startY[c], startZ[c]);
+            rays.push_back({origin, glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-3f)), 100.0f});
+            continue;
+        }
+        glm::vec3 origin = glm::vec3(unit(rng), 0.5f * (unit(rng) + 1.0f), unit(rng)) * 5.0f;
+        glm::vec3 target(unit(rng) * 0.5f, 1.0f + unit(rng), unit(rng) * 0.3f);
+        rays.push_back({origin, glm::normalize(target - origin), 100.0f});
+    }
+
+    std::vector<int> refIndex(rayCount), simdIndex(rayCount);
+    std::vector<float> refT(rayCount), simdT(rayCount);
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    for (int i = 0; i < rayCount; i++) refIndex[i] = CapsuleRaycast::nearestScalar(rays[i], capsules, refT[i]);
+    double referenceNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (int i = 0; i < rayCount; i++) simdIndex[i] = CapsuleRaycast::nearest(rays[i], capsules, simdT[i]);
+    double simdNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    int hits = 0, mismatches = 0, behind = 0;
+    float maxError = 0.0f;
+    for (int i = 0; i < rayCount; i++) {
+        hits += refIndex[i] >= 0;
+        behind += (refIndex[i] >= 0 && refT[i] < 0.0f) + (simdIndex[i] >= 0 && simdT[i] < 0.0f);
+        if (refIndex[i] != simdIndex[i]) {
+            mismatches++;
+            continue;
+        }
+        if (refIndex[i] >= 0) maxError = std::max(maxError, std::abs(refT[i] - simdT[i]) / std::max(1.0f, std::abs(refT[i])));
+    }
+
+    double perTest = (double)capsuleCount * rayCount;
+    std::cout << "Instruction set: " << SimdMath::instructionSet() << " (" << CapsuleRaycast::kWidth << " capsules per step)\n";
+    std::cout << "Capsules: " << capsuleCount << ", rays: " << rayCount << ", hits: " << hits << "\n";
+    std::cout << "Scalar: " << referenceNs / perTest << " ns/test\n";
+    std::cout << "SIMD:   " << simdNs / perTest << " ns/test\n";
+    std::cout << "Speedup: " << referenceNs / simdNs << "x\n";
+    std::cout << "Different capsule: " << mismatches << ", max distance error " << maxError << " (tolerance " << tolerance
+              << "), hits behind the origin: " << behind << "\n";
+
+    if (mismatches > 0 || maxError > tolerance) {
+        std::cerr << "SIMD results differ from the scalar test" << std::endl;
+        return 1;
+    }
+    if (behind > 0) {
+        std::cerr << "Hits behind the ray origin were reported" << std::endl;
+        return 1;
+    }
+    return checkScene(characterCount, std::max(1, rayCount / 10)) ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// Compares Skeleton::evaluate (SimdMath kernels) against the plain glm path it replaced and
+// reports the per-bone cost of each. Exits non-zero if the results disagree.
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "Skeleton.h"
+
+static void evaluateReference(const Skeleton& skeleton, const BoneTransform* localPoses, glm::mat4* worldTransforms, glm::mat4* palette) {
+    for (size_t i = 0; i < skeleton.size(); i++) {
+        const BoneTransform& pose = localPoses[i];
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), pose.translation) * glm::mat4_cast(pose.rotation) *
+                          glm::scale(glm::mat4(1.0f), pose.scale);
+        int parent = skeleton.parentIndices[i];
+        worldTransforms[i] = parent < 0 ? local : worldTransforms[parent] * local;
+        palette[i] = skeleton.globalInverseTransform * worldTransforms[i] * skeleton.offsetMatrices[i];
+    }
+}
+
+// Largest difference relative to the magnitude of the reference, so deep chains with large
+// translations don't fail on float rounding alone
+static float maxRelativeError(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b) {
+    float maxError = 0.0f;
+    for (size_t i = 0; i < a.size(); i++) {
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                float diff = std::abs(a[i][c][r] - b[i][c][r]);
+                maxError = std::max(maxError, diff / std::max(1.0f, std::abs(b[i][c][r])));
+            }
+        }
+    }
+    return maxError;
+}
+
+int main(int argc, char** argv) {
+    int boneCount = argc > 1 ? std::atoi(argv[1]) : 128;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20000;
+    const float tolerance = 1e-4f;
+
+    // Humanoid-ish hierarchy: a spine with short limb chains hanging off it
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    Skeleton skeleton;
+    std::vector<BoneTransform> poses;
+    for (int i = 0; i < boneCount; i++) {
+        int parent = i == 0 ? -1 : (i % 4 == 0 ? std::max(0, i - 4) : i - 1);
+        BoneTransform pose;
+        pose.translation = glm::vec3(unit(rng), unit(rng) + 1.0f, unit(rng)) * 0.2f;
+        pose.rotation = glm::normalize(glm::quat(unit(rng) + 2.0f, unit(rng), unit(rng), unit(rng)));
+        pose.scale = glm::vec3(1.0f + 0.05f * unit(rng));
+        skeleton.addBone("bone" + std::to_string(i), parent, pose);
+        skeleton.offsetMatrices[i] = glm::inverse(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.2f * i, 0.0f)));
+        poses.push_back(pose);
+    }
+    skeleton.globalInverseTransform = glm::scale(glm::mat4(1.0f), glm::vec3(0.01f));
+
+    std::vector<glm::mat4> refWorld(boneCount), refPalette(boneCount), world(boneCount), palette(boneCount);
+    evaluateReference(skeleton, poses.data(), refWorld.data(), refPalette.data());
+    skeleton.evaluate(poses.data(), world.data(), palette.data());
+    float worldError = maxRelativeError(world, refWorld);
+    float paletteError = maxRelativeError(palette, refPalette);
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        evaluateReference(skeleton, poses.data(), refWorld.data(), refPalette.data());
+    }
+    double referenceNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        skeleton.evaluate(poses.data(), world.data(), palette.data());
+    }
+    double simdNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    // Keep the loops from being optimized away
+    volatile float sink = refPalette.back()[3][0] + palette.back()[3][0];
+    (void)sink;
+
+    double perBone = (double)boneCount * iterations;
+    std::cout << "Instruction set: " << SimdMath::instructionSet() << "\n";
+    std::cout << "Bones: " << boneCount << ", iterations: " << iterations << "\n";
+    std::cout << "Reference: " << referenceNs / perBone << " ns/bone\n";
+    std::cout << "SimdMath:  " << simdNs / perBone << " ns/bone\n";
+    std::cout << "Speedup:   " << referenceNs / simdNs << "x\n";
+    std::cout << "Max error: world " << worldError << ", palette " << paletteError << " (tolerance " << tolerance << ")\n";
+
+    if (worldError > tolerance || paletteError > tolerance) {
+        std::cerr << "SIMD results differ from the reference beyond tolerance" << std::endl;
+        return 1;
+    }
+    return 0;
+}
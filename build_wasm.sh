@@ -3,21 +3,39 @@ set -e
 
 # This script builds the Character Runtime Player for the web using Emscripten.
 # Requirements: emcc, emcmake (part of Emscripten SDK)
+#
+# --streaming builds a player that preloads nothing and streams the character from the chunks in
+# assets/stream instead (core first, then meshes and texture levels).
+
+STREAMING=OFF
+if [ "$1" == "--streaming" ]; then
+    STREAMING=ON
+fi
 
 # 1. Prepare assets folder
 echo "Preparing assets..."
 mkdir -p assets
-# Copy current character configuration and model to assets folder for preloading
+# Copy current character configuration to the assets folder
 cp cmake-build-debug/soldier.asset.json assets/ 2>/dev/null || true
-cp cmake-build-debug/soldier.fbx assets/ 2>/dev/null || true
-cp cmake-build-debug/*.png assets/ 2>/dev/null || true
-cp cmake-build-debug/*.jpg assets/ 2>/dev/null || true
+
+# The player loads the baked binary, so the FBX import runs here on the host instead of in the browser
+echo "Baking character..."
+cmake -S . -B build_tools -DHEADLESS_ONLY=ON
+cmake --build build_tools --target asset_baker
+# soldier.fbx and its textures are found next to the description it was exported with; the
+# textures end up inside soldier.character as mip chains in BC, ETC2 and RGBA8
+if [ "$STREAMING" == "ON" ]; then
+    mkdir -p assets/stream
+    ./build_tools/asset_baker cmake-build-debug/soldier.asset.json assets/soldier.character --chunks assets/stream
+else
+    ./build_tools/asset_baker cmake-build-debug/soldier.asset.json assets/soldier.character
+fi
 
 # 2. Build using CMake and Emscripten
 echo "Starting build..."
 mkdir -p build_wasm
 cd build_wasm
-emcmake cmake ..
+emcmake cmake .. -DRUNTIME_WASM_STREAMING=$STREAMING
 cmake --build . --target runtime_player
 
 # 3. Output results
@@ -27,7 +45,11 @@ echo "Output files generated in 'build_wasm/':"
 echo "  - runtime_player.html"
 echo "  - runtime_player.js"
 echo "  - runtime_player.wasm"
-echo "  - runtime_player.data (contains preloaded assets)"
+if [ "$STREAMING" == "ON" ]; then
+    echo "  - assets/ (manifest.json and the chunks, fetched at runtime)"
+else
+    echo "  - runtime_player.data (contains the preloaded soldier.character)"
+fi
 echo "-------------------------------------------------------"
 echo "To view in your browser:"
 echo "1. Start a local web server in the 'build_wasm' directory."
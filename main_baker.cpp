@@ -0,0 +1,122 @@
+// Offline baker: imports the FBX an asset description points at, applies its clip compression
+// and palette bakes, bakes its textures to GPU formats and writes the binary .character file the
+// runtimes load.
+//
+// Usage: asset_baker <asset.json> [output.character] [--chunks <directory>]
+//
+// --chunks also splits the result into streaming chunks (see AssetChunks.h) in directory and
+// lists them in its manifest.json.
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <chrono>
+#include "AssetBaking.h"
+#include "CharacterSetup.h"
+#include "FBXImporter.h"
+#include "CharacterAssetFile.h"
+#include "TextureBaker.h"
+#include "AssetChunks.h"
+#include "JobSystem.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#undef STB_IMAGE_IMPLEMENTATION
+
+static std::string directoryOf(const std::string& path) {
+    size_t lastSlash = path.find_last_of("/\\");
+    return lastSlash == std::string::npos ? "" : path.substr(0, lastSlash + 1);
+}
+
+int main(int argc, char** argv) {
+    std::string assetPath, outputPath, chunksDirectory;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--chunks" && i + 1 < argc) chunksDirectory = argv[++i];
+        else if (assetPath.empty()) assetPath = arg;
+        else outputPath = arg;
+    }
+    if (assetPath.empty()) {
+        std::cerr << "Usage: asset_baker <asset.json> [output.character] [--chunks <directory>]" << std::endl;
+        return 1;
+    }
+    if (outputPath.empty()) {
+        const std::string suffix = ".asset.json";
+        bool hasSuffix = assetPath.size() > suffix.size() && assetPath.compare(assetPath.size() - suffix.size(), suffix.size(), suffix) == 0;
+        outputPath = (hasSuffix ? assetPath.substr(0, assetPath.size() - suffix.size()) : assetPath) + ".character";
+    }
+
+    BakedAsset asset = AssetBaking::load(assetPath);
+
+    // The skeleton path is relative to the working directory, or failing that to the description
+    std::string fbxPath = asset.skeleton;
+    if (!std::ifstream(fbxPath)) fbxPath = directoryOf(assetPath) + asset.skeleton;
+
+    using Clock = std::chrono::steady_clock;
+    auto msSince = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    JobSystem jobs;
+    ImportTimings importTimings;
+    std::shared_ptr<CharacterAsset> characterAsset = FBXImporter::load(fbxPath, &jobs, &importTimings);
+    if (!characterAsset) {
+        std::cerr << "Failed to import " << fbxPath << std::endl;
+        return 1;
+    }
+
+    auto start = Clock::now();
+    CharacterSetup::prepareAsset(asset, *characterAsset, &jobs);
+    double prepareMs = msSince(start);
+
+    // Texture paths are resolved here once; the runtimes only look baked textures up by name
+    start = Clock::now();
+    std::vector<TextureBakeReport> textureReports =
+        TextureBaker::bakeTextures(*characterAsset, fbxPath, {directoryOf(assetPath)}, asset.textureFormats, &jobs);
+    double textureMs = msSince(start);
+    double decodeMs = 0.0, encodeMs = 0.0;
+    for (const auto& report : textureReports) {
+        std::cout << "Baked texture " << (report.resolvedPath.empty() ? report.name : report.resolvedPath) << " ("
+                  << report.width << "x" << report.height << ", " << report.levelCount << " levels):";
+        for (const auto& [format, bytes] : report.payloadBytes) {
+            std::cout << " " << TextureBaker::formatName(format) << " " << bytes / 1024 << " KB";
+        }
+        std::cout << std::endl;
+        decodeMs += report.decodeMs;
+        encodeMs += report.encodeMs;
+    }
+
+    start = Clock::now();
+    if (!CharacterAssetFile::save(outputPath, *characterAsset, asset)) return 1;
+    double saveMs = msSince(start);
+
+    double chunksMs = 0.0;
+    if (!chunksDirectory.empty()) {
+        // Chunks are named after the output file: soldier.character -> soldier.core.character, ...
+        std::string name = outputPath.substr(directoryOf(outputPath).size());
+        if (name.size() > 10 && name.compare(name.size() - 10, 10, ".character") == 0) name.resize(name.size() - 10);
+        start = Clock::now();
+        if (!AssetChunks::write(chunksDirectory, name, *characterAsset, asset)) return 1;
+        chunksMs = msSince(start);
+        std::cout << "Wrote streaming chunks of " << name << " to " << chunksDirectory << std::endl;
+    }
+
+    // Load it back the way the runtimes do, to check it and to compare startup cost
+    start = Clock::now();
+    std::shared_ptr<CharacterAsset> loaded = CharacterAssetFile::load(outputPath);
+    double loadMs = msSince(start);
+    if (!loaded) return 1;
+
+    std::ifstream written(outputPath, std::ios::binary | std::ios::ate);
+    std::cout << "Wrote " << outputPath << " (" << (long long)written.tellg() / 1024 << " KB): "
+              << loaded->getSkeleton().size() << " bones, " << loaded->getMeshes().size() << " meshes, "
+              << loaded->getClips().size() << " clips, " << loaded->getBakedTextures().size() << " textures" << std::endl;
+    // Stages inside the parallel batches report summed per-item (CPU) time next to the batch's wall time
+    std::cout << "Stage timings on " << jobs.getThreadCount() << " threads (ms):" << std::endl;
+    std::cout << "  FBX import      " << importTimings.totalMs << " (read " << importTimings.readMs << ", skeleton "
+              << importTimings.skeletonMs << ", extraction " << importTimings.extractMs << " wall: meshes "
+              << importTimings.meshesMs << ", clips " << importTimings.clipsMs << ", embedded textures "
+              << importTimings.texturesMs << ")" << std::endl;
+    std::cout << "  prepare         " << prepareMs << " (mesh optimization, compression, palette bakes)" << std::endl;
+    std::cout << "  texture bake    " << textureMs << " wall (decode + mips " << decodeMs << ", encode " << encodeMs << ")" << std::endl;
+    std::cout << "  save            " << saveMs << std::endl;
+    if (!chunksDirectory.empty()) std::cout << "  chunks          " << chunksMs << std::endl;
+    std::cout << "  binary load     " << loadMs << " (what the runtimes pay instead of the import)" << std::endl;
+    return 0;
+}
@@ -1,15 +1,23 @@
 #include <iostream>
+#include <memory>
 #include <vector>
+#include <cstdlib>
+#include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#undef STB_IMAGE_IMPLEMENTATION
 #include "FBXStateMachine.h"
 #include "CharacterPhysics.h"
 #include "SkinnedRenderer.h"
 #include "AssetBaking.h"
+#include "JobSystem.h"
+#include "AnimationLOD.h"
+#include "CharacterSetup.h"
+#include "AssetDatabase.h"
+#include "TextureUpload.h"
+#include "ChunkFetcher.h"
+#include "CharacterStream.h"
+#include "AssetChunks.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -21,10 +29,16 @@
 #endif
 
 FBXStateMachine stateMachine;
+JobSystem* jobs = nullptr;
+AnimationScheduler scheduler;
 CharacterPhysics physics;
 SkinnedRenderer renderer;
 BakedAsset asset;
 GLFWwindow* window = nullptr;
+// Streaming mode only; the stream owns GL textures, so both go before the context does
+std::unique_ptr<ChunkFetcher> chunkFetcher;
+std::unique_ptr<CharacterStream> chunkStream;
+std::chrono::steady_clock::time_point startTime;
 
 void update() {
     static float lastTime = (float)glfwGetTime();
@@ -32,16 +46,31 @@ void update() {
     float dt = currentTime - lastTime;
     lastTime = currentTime;
 
-    stateMachine.update(dt);
-    physics.update(stateMachine.getBones(), glm::mat4(1.0f));
-    
+    // A streamed character has nothing to animate until its core chunk is in
+    if (chunkFetcher) chunkFetcher->poll();
+    bool loaded = stateMachine.getAsset() != nullptr;
+    if (loaded) {
+        FBXStateMachine* characters[] = {&stateMachine};
+        AnimationLODInput lodInputs[1];
+        lodInputs[0].distance = glm::length(renderer.getCameraPosition());  // character sits at the origin
+        scheduler.update(characters, lodInputs, 1, dt, jobs);
+        physics.update(stateMachine.getBones(), glm::mat4(1.0f));
+    }
+
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
     glViewport(0, 0, width, height);
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    renderer.render(stateMachine.getFinalBoneMatrices());
+    if (loaded) renderer.render(stateMachine.getFinalBoneMatrices());
+
+    static bool firstFrame = true;
+    if (firstFrame) {
+        firstFrame = false;
+        std::cout << "First frame at " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()
+                  << " ms" << std::endl;
+    }
 
 #ifndef __EMSCRIPTEN__
     glfwSwapBuffers(window);
@@ -57,14 +86,40 @@ extern "C" {
     bool shoot(float x, float y, float z, float dx, float dy, float dz) {
         HitResult hit;
         if (physics.raycast(glm::vec3(x,y,z), glm::vec3(dx,dy,dz), 100.0f, hit)) {
-            std::cout << "Hit bone: " << hit.boneName << " damage: " << hit.damage << std::endl;
+            std::cout << "Hit bone: " << CharacterPhysics::boneName(stateMachine.getSkeleton(), hit) << " damage: " << hit.damage << std::endl;
             return true;
         }
         return false;
     }
+
+    // rays: count x (origin xyz, direction xyz). hitBones, if not null, receives the bone index per
+    // ray (-1 for a miss). Returns how many rays hit.
+    int shootBatch(const float* rays, int count, int* hitBones) {
+        std::vector<Ray> batch(count);
+        for (int i = 0; i < count; i++) {
+            const float* r = rays + i * 6;
+            batch[i] = {glm::vec3(r[0], r[1], r[2]), glm::vec3(r[3], r[4], r[5]), 100.0f};
+        }
+        std::vector<HitResult> hits(count);
+        int hitCount = (int)physics.raycastBatch(batch.data(), batch.size(), hits.data(), jobs);
+        if (hitBones) {
+            for (int i = 0; i < count; i++) hitBones[i] = hits[i].boneIndex;
+        }
+        return hitCount;
+    }
 }
 
 int main() {
+    startTime = std::chrono::steady_clock::now();
+    // ANIM_THREADS sets the animation thread count (0 = one per core); the browser build without
+    // pthreads always runs single-threaded
+    const char* threadsEnv = std::getenv("ANIM_THREADS");
+    static JobSystem jobSystem(threadsEnv ? (unsigned int)std::atoi(threadsEnv) : 0);
+    jobs = &jobSystem;
+    // ANIM_BUDGET_MS caps the wall-clock time spent on animation updates per frame (0 = no cap)
+    const char* budgetEnv = std::getenv("ANIM_BUDGET_MS");
+    scheduler.setCpuBudget(budgetEnv ? (float)std::atof(budgetEnv) : 0.0f);
+
     if (!glfwInit()) return -1;
     
 #ifdef __EMSCRIPTEN__
@@ -84,50 +139,92 @@ int main() {
 
     glEnable(GL_DEPTH_TEST);
 
-    const char* asset_path = "assets/soldier.asset.json";
-#ifdef __EMSCRIPTEN__
-    if (FILE *file = fopen(asset_path, "r")) {
-        fclose(file);
-    } else {
-        std::cerr << "Warning: " << asset_path << " not found, trying local path." << std::endl;
-        asset_path = "soldier.asset.json";
-    }
-#endif
+    // ASSET_CPU_BUDGET_MB / ASSET_GPU_BUDGET_MB cap what the asset database keeps resident once
+    // nothing uses it (0 = no cap)
+    AssetDatabase& database = AssetDatabase::instance();
+    const char* cpuBudgetEnv = std::getenv("ASSET_CPU_BUDGET_MB");
+    const char* gpuBudgetEnv = std::getenv("ASSET_GPU_BUDGET_MB");
+    AssetDatabase::Budget budget;
+    budget.cpuBytes = cpuBudgetEnv ? (size_t)(std::atof(cpuBudgetEnv) * 1024 * 1024) : 0;
+    budget.gpuBytes = gpuBudgetEnv ? (size_t)(std::atof(gpuBudgetEnv) * 1024 * 1024) : 0;
+    database.setBudget(budget);
+    TextureUpload::Support textureSupport = TextureUpload::querySupport();
+    database.setTextureBackend(TextureUpload::databaseBackend(textureSupport));
 
-    asset = AssetBaking::load(asset_path);
-    std::cout << "Loaded asset: " << asset.skeleton << " from " << asset_path << std::endl;
-    
-    std::string fbx_path = asset.skeleton;
+    // Streaming: boot with the chunk manifest only and let the character arrive in pieces. The
+    // streaming WASM build fetches it over HTTP next to the page; ASSET_MANIFEST points a desktop
+    // build at a chunk directory, with STREAM_DELAY_MS per chunk to mimic a slow network.
+#ifdef RUNTIME_STREAMING
+    std::string manifestPath = "assets/manifest.json";
+#else
+    const char* manifestEnv = std::getenv("ASSET_MANIFEST");
+    std::string manifestPath = manifestEnv ? manifestEnv : "";
+#endif
+    if (!manifestPath.empty()) {
+        size_t lastSlash = manifestPath.find_last_of('/');
+        std::string base = lastSlash == std::string::npos ? "" : manifestPath.substr(0, lastSlash + 1);
+        const char* delayEnv = std::getenv("STREAM_DELAY_MS");
+        chunkFetcher = std::make_unique<ChunkFetcher>(base, delayEnv ? std::atoi(delayEnv) : 0);
+        chunkStream = std::make_unique<CharacterStream>(*chunkFetcher, renderer, textureSupport);
+        renderer.initProgram();
+        chunkFetcher->fetch(manifestPath.substr(base.size()), [](bool ok, std::vector<uint8_t>& data) {
+            AssetChunks::Manifest manifest;
+            if (!ok || !AssetChunks::parseManifest(std::string(data.begin(), data.end()), manifest)) return;
+            const char* characterEnv = std::getenv("STREAM_CHARACTER");
+            const AssetChunks::Character* character = manifest.find(characterEnv ? characterEnv : "soldier");
+            if (!character && !manifest.characters.empty()) character = &manifest.characters[0];
+            if (!character) {
+                std::cerr << "The manifest lists no characters" << std::endl;
+                return;
+            }
+            chunkStream->start(*character, [](std::shared_ptr<const CharacterAsset> core, const BakedAsset& config) {
+                asset = config;
+                stateMachine.setAsset(std::move(core));
+                if (!asset.lodTiers.empty()) scheduler.setTiers(asset.lodTiers, asset.lodOffscreenTier);
+                CharacterSetup::configure(asset, stateMachine, physics);
+            });
+        });
+    } else {
+        // Baked by asset_baker from soldier.asset.json; no FBX import at startup
+        const char* asset_path = "assets/soldier.character";
 #ifdef __EMSCRIPTEN__
-    if (fbx_path.find("assets/") != 0) {
-        fbx_path = "assets/" + fbx_path;
-    }
+        if (FILE *file = fopen(asset_path, "r")) {
+            fclose(file);
+        } else {
+            std::cerr << "Warning: " << asset_path << " not found, trying local path." << std::endl;
+            asset_path = "soldier.character";
+        }
 #endif
-    stateMachine.loadFBX(fbx_path);
-    std::cout << "Loaded FBX: " << stateMachine.getMeshes().size() << " meshes, " 
-              << stateMachine.getBones().size() << " bones." << std::endl;
-
-    for (auto const& [name, index] : asset.states) {
-        if (name == "IDLE") stateMachine.setAnimationMapping(IDLE, index);
-        else if (name == "RUN") stateMachine.setAnimationMapping(RUN, index);
-        else if (name == "JUMP") stateMachine.setAnimationMapping(JUMP, index);
-    }
-    
-    std::vector<Capsule> capsules;
-    for(auto& c : asset.colliders) {
-        capsules.push_back({c.bone, c.radius, c.height, c.damage});
-    }
-    physics.setupColliders(capsules);
-    
-    renderer.init(stateMachine.getMeshes());
-    if (stateMachine.getMeshes().empty()) {
-        std::cerr << "Warning: No meshes found in the FBX file!" << std::endl;
+
+        auto loadStart = std::chrono::steady_clock::now();
+        AssetDatabase::CharacterHandle characterAsset = database.character(asset_path, &asset);
+        if (!characterAsset) return -1;
+        std::cout << "Loaded asset: " << asset.skeleton << " from " << asset_path << " in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count() << " ms" << std::endl;
+        stateMachine.setAsset(characterAsset);
+        if (!asset.lodTiers.empty()) scheduler.setTiers(asset.lodTiers, asset.lodOffscreenTier);
+        std::cout << "Character: " << stateMachine.getMeshes().size() << " meshes, "
+                  << stateMachine.getBones().size() << " bones." << std::endl;
+
+        CharacterSetup::configure(asset, stateMachine, physics);
+
+        auto uploadStart = std::chrono::steady_clock::now();
+        renderer.init(database, asset_path);
+        AssetDatabase::Stats stats = database.getStats();
+        std::cout << "Uploaded " << stats.residentTextures << " baked textures and meshes in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count() << " ms ("
+                  << stats.cpuBytes / 1024 << " KB CPU, " << stats.gpuBytes / 1024 << " KB GPU resident)" << std::endl;
+        if (stateMachine.getMeshes().empty()) {
+            std::cerr << "Warning: No meshes found in the character file!" << std::endl;
+        }
     }
 
 #ifdef __EMSCRIPTEN__
     emscripten_set_main_loop(update, 0, 1);
 #else
     while (!glfwWindowShouldClose(window)) { update(); }
+    chunkStream.reset();
+    chunkFetcher.reset();
     glfwTerminate();
 #endif
     return 0;
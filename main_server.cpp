@@ -0,0 +1,273 @@
+// Headless authoritative simulation: N characters animated and hit-tested at a fixed tick rate,
+// driven by a command script, with no window or GL context.
+//
+// Usage: runtime_server [asset.character] [--characters N] [--rate HZ] [--ticks N] [--threads N]
+//                            [--commands FILE|-] [--skin] [--realtime]
+//
+// Command script, one command per line ('#' starts a comment); character is an index or '*':
+//   <tick> setState <character> <IDLE|RUN|JUMP>
+//   <tick> shoot <character> <ox> <oy> <oz> <dx> <dy> <dz>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "FBXStateMachine.h"
+#include "CharacterPhysics.h"
+#include "PhysicsScene.h"
+#include "CpuSkinning.h"
+#include "AssetBaking.h"
+#include "CharacterSetup.h"
+#include "AssetDatabase.h"
+#include "JobSystem.h"
+
+struct Command {
+    long tick = 0;
+    std::string name;
+    int character = -1;  // -1 targets every character
+    std::vector<float> args;
+};
+
+struct ServerCharacter {
+    FBXStateMachine stateMachine;
+    CharacterPhysics physics;
+    int body = -1;  // in the PhysicsScene
+    glm::mat4 modelTransform = glm::mat4(1.0f);
+    std::vector<std::vector<glm::vec3>> skinnedMeshes;  // only with --skin
+};
+
+static bool parseState(const std::string& text, State& state) {
+    if (text == "IDLE" || text == "0") state = IDLE;
+    else if (text == "RUN" || text == "1") state = RUN;
+    else if (text == "JUMP" || text == "2") state = JUMP;
+    else return false;
+    return true;
+}
+
+static std::vector<Command> loadCommands(std::istream& in) {
+    std::vector<Command> commands;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+        Command command;
+        std::string target;
+        if (!(tokens >> command.tick >> command.name >> target)) continue;
+        command.character = target == "*" ? -1 : std::atoi(target.c_str());
+        if (command.name == "setState") {
+            std::string state;
+            tokens >> state;
+            State parsed;
+            if (!parseState(state, parsed)) {
+                std::cerr << "Line " << lineNumber << ": unknown state '" << state << "'" << std::endl;
+                continue;
+            }
+            command.args.push_back((float)parsed);
+        } else if (command.name == "shoot") {
+            float value;
+            while (tokens >> value) command.args.push_back(value);
+            if (command.args.size() != 6) {
+                std::cerr << "Line " << lineNumber << ": shoot needs origin and direction" << std::endl;
+                continue;
+            }
+        } else {
+            std::cerr << "Line " << lineNumber << ": unknown command '" << command.name << "'" << std::endl;
+            continue;
+        }
+        commands.push_back(command);
+    }
+    std::stable_sort(commands.begin(), commands.end(), [](const Command& a, const Command& b) { return a.tick < b.tick; });
+    return commands;
+}
+
+// Every shot of a tick at once. Shots at every character go through the scene's broadphase in
+// one batch; a shot at one character only tests that character's capsules.
+static void shoot(std::vector<ServerCharacter>& characters, const PhysicsScene& scene, const std::vector<const Command*>& shots,
+                  long tick, JobSystem& jobs) {
+    std::vector<Ray> rays(shots.size());
+    for (size_t s = 0; s < shots.size(); s++) {
+        const Command& command = *shots[s];
+        glm::vec3 origin(command.args[0], command.args[1], command.args[2]);
+        glm::vec3 direction = glm::normalize(glm::vec3(command.args[3], command.args[4], command.args[5]));
+        rays[s] = {origin, direction, 100000.0f};
+    }
+
+    std::vector<PhysicsScene::Hit> hits(shots.size());
+    std::vector<Ray> sceneRays;
+    std::vector<size_t> sceneShots;
+    for (size_t s = 0; s < shots.size(); s++) {
+        int target = shots[s]->character;
+        if (target < 0) {
+            sceneRays.push_back(rays[s]);
+            sceneShots.push_back(s);
+        } else if (target < (int)characters.size() && characters[target].physics.raycast(rays[s], hits[s].hit)) {
+            hits[s].body = characters[target].body;
+        }
+    }
+    if (!sceneRays.empty()) {
+        std::vector<PhysicsScene::Hit> sceneHits(sceneRays.size());
+        scene.raycastBatch(sceneRays.data(), sceneRays.size(), sceneHits.data(), &jobs);
+        for (size_t r = 0; r < sceneRays.size(); r++) hits[sceneShots[r]] = sceneHits[r];
+    }
+
+    // Scene body ids are the character indices, as every character was added once in order
+    for (size_t s = 0; s < shots.size(); s++) {
+        int hitCharacter = hits[s].body;
+        if (hitCharacter >= 0) {
+            std::cout << "[tick " << tick << "] hit character " << hitCharacter << " bone "
+                      << CharacterPhysics::boneName(characters[hitCharacter].stateMachine.getSkeleton(), hits[s].hit)
+                      << " damage " << hits[s].hit.damage << std::endl;
+        } else {
+            std::cout << "[tick " << tick << "] miss" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string assetPath = "assets/soldier.character";
+    int characterCount = 100;
+    float rate = 30.0f;
+    long tickCount = 900;
+    unsigned int threadCount = 0;
+    std::string commandsPath;
+    bool skin = false;
+    bool realtime = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--characters" && hasValue) characterCount = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--rate" && hasValue) rate = std::max(1.0f, (float)std::atof(argv[++i]));
+        else if (arg == "--ticks" && hasValue) tickCount = std::max(1L, std::atol(argv[++i]));
+        else if (arg == "--threads" && hasValue) threadCount = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--commands" && hasValue) commandsPath = argv[++i];
+        else if (arg == "--skin") skin = true;
+        else if (arg == "--realtime") realtime = true;
+        else if (arg.rfind("--", 0) != 0) assetPath = arg;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    BakedAsset asset;
+    AssetDatabase::CharacterHandle characterAsset = AssetDatabase::instance().character(assetPath, &asset);
+    if (!characterAsset) {
+        std::cerr << "Failed to load " << assetPath << std::endl;
+        return 1;
+    }
+
+    std::vector<Command> commands;
+    if (commandsPath == "-") {
+        commands = loadCommands(std::cin);
+    } else if (!commandsPath.empty()) {
+        std::ifstream file(commandsPath);
+        if (!file) {
+            std::cerr << "Cannot open command file " << commandsPath << std::endl;
+            return 1;
+        }
+        commands = loadCommands(file);
+    }
+
+    JobSystem jobs(threadCount);
+
+    // Characters stand on a square grid, 200 units apart
+    std::vector<ServerCharacter> characters(characterCount);
+    std::vector<FBXStateMachine*> instances;
+    int gridSize = (int)std::ceil(std::sqrt((float)characterCount));
+    for (int i = 0; i < characterCount; i++) {
+        ServerCharacter& character = characters[i];
+        character.stateMachine.setAsset(characterAsset);
+        CharacterSetup::configure(asset, character.stateMachine, character.physics);
+        character.modelTransform = glm::translate(glm::mat4(1.0f), glm::vec3((i % gridSize) * 200.0f, 0.0f, (i / gridSize) * 200.0f));
+        if (skin) {
+            for (const auto& mesh : characterAsset->getMeshes()) character.skinnedMeshes.emplace_back(mesh.vertices.size());
+        }
+        instances.push_back(&character.stateMachine);
+    }
+    PhysicsScene scene;
+    for (ServerCharacter& character : characters) character.body = scene.add(character.physics);
+
+    std::cout << "Simulating " << characterCount << " characters (" << characterAsset->getSkeleton().size()
+              << " bones) at " << rate << " Hz for " << tickCount << " ticks on " << jobs.getThreadCount()
+              << " threads" << (skin ? ", with CPU skinning" : "") << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    const float dt = 1.0f / rate;
+    const auto tickPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(dt));
+    std::vector<double> tickMs;
+    tickMs.reserve(tickCount);
+    size_t nextCommand = 0;
+    auto nextTickTime = Clock::now();
+
+    for (long tick = 0; tick < tickCount; tick++) {
+        auto start = Clock::now();
+
+        size_t firstShoot = nextCommand;
+        for (; nextCommand < commands.size() && commands[nextCommand].tick <= tick; nextCommand++) {
+            const Command& command = commands[nextCommand];
+            if (command.name != "setState") continue;
+            for (int i = 0; i < characterCount; i++) {
+                if (command.character < 0 || command.character == i) characters[i].stateMachine.setState((State)(int)command.args[0]);
+            }
+        }
+
+        FBXStateMachine::updateBatch(instances.data(), instances.size(), dt, &jobs);
+        jobs.parallelFor(characters.size(), 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                ServerCharacter& character = characters[i];
+                character.physics.update(character.stateMachine.getBones(), character.modelTransform);
+                for (size_t m = 0; m < character.skinnedMeshes.size(); m++) {
+                    CpuSkinning::skin(characterAsset->getMeshes()[m], character.stateMachine.getFinalBoneMatrices(),
+                                      character.skinnedMeshes[m].data(), nullptr);
+                }
+            }
+        });
+        scene.update(&jobs);
+
+        // Shots resolve against this tick's pose
+        std::vector<const Command*> shots;
+        for (size_t c = firstShoot; c < nextCommand; c++) {
+            if (commands[c].name == "shoot") shots.push_back(&commands[c]);
+        }
+        if (!shots.empty()) shoot(characters, scene, shots, tick, jobs);
+
+        tickMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+        if (realtime) {
+            nextTickTime += tickPeriod;
+            std::this_thread::sleep_until(nextTickTime);
+        }
+    }
+
+    std::vector<double> sorted = tickMs;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+    double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+    double budgetMs = 1000.0 / rate;
+    // Characters one core could carry at this rate, extrapolated from the mean tick
+    double perCore = characterCount * budgetMs / (mean * jobs.getThreadCount());
+
+    std::cout << "Tick time (ms): mean " << mean << ", p50 " << percentile(0.50) << ", p95 " << percentile(0.95)
+              << ", p99 " << percentile(0.99) << ", max " << sorted.back() << std::endl;
+    std::cout << "Budget " << budgetMs << " ms per tick, " << 100.0 * mean / budgetMs << "% used" << std::endl;
+    std::cout << "Estimated capacity: " << (int)perCore << " characters per core at " << rate << " Hz" << std::endl;
+    PhysicsScene::Stats sceneStats = scene.getStats();
+    if (sceneStats.rays > 0) {
+        std::cout << "Broadphase: " << sceneStats.rays << " rays, " << (double)sceneStats.nodesVisited / sceneStats.rays
+                  << " tree nodes and " << (double)sceneStats.bodiesTested / sceneStats.rays << " characters tested per ray (tree height "
+                  << scene.treeHeight() << ", " << sceneStats.reinserts << " leaf reinserts)" << std::endl;
+    }
+    return 0;
+}